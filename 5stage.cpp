@@ -7,10 +7,10 @@ int main(int argc, char *argv[])
 		std::cerr << "Required argument: file_name\n./MIPS_interpreter <file name>\n";
 		return 0;
 	}
-	std::ifstream file(argv[1]);
-	MIPS_Architecture *mips;
-	if (file.is_open())
-		mips = new MIPS_Architecture(file);
+	SourceText source;
+	MIPS_5Stage *mips;
+	if (source.open(argv[1]))
+		mips = new MIPS_5Stage(std::move(source));
 	else
 	{
 		std::cerr << "File could not be opened. Terminating...\n";
@@ -18,5 +18,6 @@ int main(int argc, char *argv[])
 	}
 
 	mips->executeCommandsPipelined();
+	delete mips;
 	return 0;
 }
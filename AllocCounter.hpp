@@ -0,0 +1,48 @@
+/**
+ * @file AllocCounter.hpp
+ * @brief Heap allocation counter for debug builds (compile with -DMIPS_COUNT_ALLOCS)
+ *
+ * The replacement operator new below is not inline, so this header may only be
+ * included from a single translation unit, which holds for every simulator binary.
+ */
+
+#ifndef __ALLOC_COUNTER_HPP__
+#define __ALLOC_COUNTER_HPP__
+
+#ifdef MIPS_COUNT_ALLOCS
+
+#include <cstdlib>
+#include <atomic>
+#include <cassert>
+#include <new>
+
+// counted from every thread, the parallel loaders and the simulator pool allocate too
+static std::atomic<unsigned long long> heapAllocations{0};
+
+__attribute__((noinline)) void *operator new(std::size_t size)
+{
+	heapAllocations.fetch_add(1, std::memory_order_relaxed);
+	if (void *p = std::malloc(size ? size : 1))
+		return p;
+	throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void operator delete(void *p) noexcept
+{
+	std::free(p);
+}
+
+__attribute__((noinline)) void operator delete(void *p, std::size_t) noexcept
+{
+	std::free(p);
+}
+
+// number of operator new calls so far
+inline unsigned long long allocationCount()
+{
+	return heapAllocations.load(std::memory_order_relaxed);
+}
+
+#endif
+
+#endif
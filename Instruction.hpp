@@ -0,0 +1,167 @@
+/**
+ * @file Instruction.hpp
+ * @brief Pre-decoded instruction record shared by all the pipeline models
+ *
+ */
+
+#ifndef __INSTRUCTION_HPP__
+#define __INSTRUCTION_HPP__
+
+#include <unordered_map>
+#include <string>
+#include <cstdint>
+#include <type_traits>
+#include "Lexer.hpp"
+
+enum class Opcode : uint8_t
+{
+	add,
+	sub,
+	mul,
+	slt,
+	addi,
+	beq,
+	bne,
+	j,
+	lw,
+	sw,
+	nop,
+	end,
+	invalid
+};
+
+/*
+	operand layout per opcode:
+		add, sub, mul, slt:	r1 = r2 op r3
+		addi:				r1 = r2 + imm
+		beq, bne:			compare r1, r2 and go to target
+		j:					go to target
+		lw, sw:				r1 <-> data[r2 + imm]
+		nop:				nothing, locks no register
+*/
+struct Instruction
+{
+	Opcode op = Opcode::invalid;
+	uint8_t r1 = 0, r2 = 0, r3 = 0;
+	int imm = 0;
+	int target = 0;
+};
+
+static_assert(std::is_trivially_copyable<Instruction>::value, "Instruction must stay trivially copyable");
+
+// map a mnemonic to its opcode
+inline Opcode opcodeOf(std::string_view name)
+{
+	static const std::unordered_map<std::string_view, Opcode> opcodes = {{"add", Opcode::add}, {"sub", Opcode::sub}, {"mul", Opcode::mul}, {"slt", Opcode::slt}, {"addi", Opcode::addi}, {"beq", Opcode::beq}, {"bne", Opcode::bne}, {"j", Opcode::j}, {"lw", Opcode::lw}, {"sw", Opcode::sw}};
+	auto it = opcodes.find(name);
+	return it == opcodes.end() ? Opcode::invalid : it->second;
+}
+
+/*
+	register index of a name, -1 if it is not one: $0 to $31 and the conventional names
+	($zero, $at, $v0-1, $a0-3, $t0-9, $s0-8, $k0-1, $gp, $sp, $ra), resolved by switching on
+	the characters so no table is built at run time
+*/
+constexpr int registerIndex(std::string_view r)
+{
+	if (r.size() < 2 || r[0] != '$')
+		return -1;
+	const char c = r[1];
+	if (c >= '0' && c <= '9')
+	{
+		if (r.size() == 2)
+			return c - '0';
+		if (r.size() == 3 && c != '0' && r[2] >= '0' && r[2] <= '9' && (c - '0') * 10 + r[2] - '0' < 32)
+			return (c - '0') * 10 + r[2] - '0';
+		return -1;
+	}
+	if (r == "$zero")
+		return 0;
+	if (r.size() != 3)
+		return -1;
+	const char d = r[2];
+	switch (c)
+	{
+	case 'a':
+		return d == 't' ? 1 : d >= '0' && d <= '3' ? 4 + d - '0' : -1;
+	case 'v':
+		return d >= '0' && d <= '1' ? 2 + d - '0' : -1;
+	case 't':
+		return d >= '0' && d <= '7' ? 8 + d - '0' : d >= '8' && d <= '9' ? 24 + d - '8' : -1;
+	case 's':
+		return d == 'p' ? 29 : d >= '0' && d <= '7' ? 16 + d - '0' : d == '8' ? 30 : -1;
+	case 'k':
+		return d >= '0' && d <= '1' ? 26 + d - '0' : -1;
+	case 'g':
+		return d == 'p' ? 28 : -1;
+	case 'r':
+		return d == 'a' ? 31 : -1;
+	default:
+		return -1;
+	}
+}
+
+static_assert(registerIndex("$zero") == 0 && registerIndex("$t9") == 25 && registerIndex("$s8") == 30 && registerIndex("$31") == 31, "register names");
+static_assert(registerIndex("$32") == -1 && registerIndex("$01") == -1 && registerIndex("$fp") == -1 && registerIndex("t0") == -1, "register names");
+
+// register index of a name, unknown names map to $zero like registerMap[] did
+constexpr uint8_t registerOf(std::string_view r)
+{
+	return registerIndex(r) < 0 ? 0 : registerIndex(r);
+}
+
+// label target, undefined and duplicate labels resolve to -1
+inline int targetOf(const std::unordered_map<std::string_view, int> &address, std::string_view label)
+{
+	auto it = address.find(label);
+	return it == address.end() ? -1 : it->second;
+}
+
+// decode a tokenised command once so that the pipeline stages never touch strings
+inline Instruction decodeInstruction(const Command &command, const std::unordered_map<std::string_view, int> &address)
+{
+	Instruction ins;
+	ins.op = opcodeOf(command[0]);
+	switch (ins.op)
+	{
+	case Opcode::add:
+	case Opcode::sub:
+	case Opcode::mul:
+	case Opcode::slt:
+		ins.r1 = registerOf(command[1]);
+		ins.r2 = registerOf(command[2]);
+		ins.r3 = registerOf(command[3]);
+		break;
+	case Opcode::addi:
+		ins.r1 = registerOf(command[1]);
+		ins.r2 = registerOf(command[2]);
+		parseInt(command[3], ins.imm); // stays 0 when malformed, the verifier reports it
+		break;
+	case Opcode::beq:
+	case Opcode::bne:
+		ins.r1 = registerOf(command[1]);
+		ins.r2 = registerOf(command[2]);
+		ins.target = targetOf(address, command[3]);
+		break;
+	case Opcode::j:
+		ins.target = targetOf(address, command[1]);
+		break;
+	case Opcode::lw:
+	case Opcode::sw:
+	{
+		// offset($reg), ($reg) or a plain address relative to $zero
+		const std::string_view location = command[2];
+		ins.r1 = registerOf(command[1]);
+		size_t lparen = location.find('(');
+		parseInt(lparen == 0 ? "0" : location.substr(0, lparen), ins.imm);
+		if (lparen != std::string_view::npos && location.back() == ')')
+			ins.r2 = registerOf(location.substr(lparen + 1, location.size() - lparen - 2));
+		break;
+	}
+	default:
+		break;
+	}
+	return ins;
+}
+
+#endif
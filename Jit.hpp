@@ -0,0 +1,432 @@
+/**
+ * @file Jit.hpp
+ * @brief Functional executor translating hot basic blocks to x86-64 code in an executable arena
+ *
+ * Blocks are interpreted until their entry has been reached hotThreshold times, then translated:
+ * the MIPS registers and data stay in the simulator's arrays, each instruction becomes a few host
+ * instructions on them, and a block's exits jump straight to the blocks already translated (exits to
+ * blocks translated later are patched when they are). Anything the translator does not handle, and
+ * every block on other hosts or when the arena cannot be mapped, runs on the interpreter. The result
+ * is that of executeCommandsUnpipelined, without its per instruction output or counts.
+ *
+ * A bounded run stops after a given number of instructions: every block exit compares the steps
+ * with the budget before it chains to the next block, and runJit enters translated code only while a
+ * whole block fits, interpreting the last instructions one by one. Translations are kept across runs
+ * of the same program.
+ */
+
+#ifndef __JIT_HPP__
+#define __JIT_HPP__
+
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "Program.hpp"
+#include "ThreadedCode.hpp"
+
+#if defined(__x86_64__) && defined(__linux__)
+#define MIPS_JIT 1
+#include <sys/mman.h>
+#endif
+
+// what the translated code reads and updates, the trampoline keeps it in callee saved registers
+struct JitContext
+{
+	int *registers;		 // rbx
+	int *data;			 // r14
+	uint64_t *dirtyBits; // r15, the simulator's DirtyPages bits
+	long long steps;	 // instructions started, through r12
+	long long stop;		 // block exits past this many steps go back to runJit
+};
+
+struct JitCode
+{
+	static const size_t ARENA_BYTES = 1 << 22;
+	static const int BLOCK_INSTRUCTIONS = 256; // longer straight line code is split into several blocks
+	static const size_t BLOCK_BYTES = BLOCK_INSTRUCTIONS * 80 + 128; // with the budget checks of its exits
+
+	int hotThreshold = 16; // interpreted entries into a block before it is translated
+
+	unsigned char *arena = nullptr;
+	size_t used = 0;
+	size_t exitOffset = 0;		  // of the trampoline's return path
+	std::vector<int> entry;		  // arena offset of the block starting at each instruction, -1 if none
+	std::vector<int> heat;		  // interpreted entries into each block
+	std::vector<std::vector<int>> waiting; // exits to each instruction still going back to runJit
+
+	JitCode() = default;
+	JitCode(const JitCode &) = delete;
+	JitCode &operator=(const JitCode &) = delete;
+
+	~JitCode()
+	{
+#ifdef MIPS_JIT
+		if (arena)
+			munmap(arena, ARENA_BYTES);
+#endif
+	}
+
+	// forget every translation, the simulator does when it loads another program
+	void clear()
+	{
+		entry.clear();
+		heat.clear();
+		waiting.clear();
+	}
+
+	// ready to translate a program of n instructions, keeping what earlier runs of it translated; false if nothing can be
+	bool ready(int n)
+	{
+		return (arena && entry.size() == (size_t)n + 1) || start(n);
+	}
+
+	// forget every translation, for a program of n instructions; false if nothing can be translated
+	bool start(int n)
+	{
+		entry.assign(n + 1, -1);
+		heat.assign(n + 1, 0);
+		waiting.assign(n + 1, std::vector<int>());
+#ifdef MIPS_JIT
+		if (!arena)
+		{
+			void *p = mmap(nullptr, ARENA_BYTES, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if (p == MAP_FAILED)
+				return false;
+			arena = (unsigned char *)p;
+		}
+		used = 0;
+		emitTrampoline();
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	// run translated code from the block at pc until it leaves translated code: the next instruction, or ~pc of a faulting lw/sw
+	int run(JitContext &context, int pc)
+	{
+		typedef int (*Trampoline)(JitContext *, const void *);
+		return ((Trampoline)(void *)arena)(&context, arena + entry[pc]);
+	}
+
+	// host code emission, x86-64 encodings
+	void byte(int b) { arena[used++] = (unsigned char)b; }
+	void bytes(std::initializer_list<int> bs)
+	{
+		for (int b : bs)
+			byte(b);
+	}
+	void dword(int32_t d)
+	{
+		memcpy(arena + used, &d, 4);
+		used += 4;
+	}
+	void patch(size_t at, size_t to)
+	{
+		int32_t rel = (int32_t)(to - (at + 4));
+		memcpy(arena + at, &rel, 4);
+	}
+
+	// op reg32, [rbx + 4 * r]
+	void onRegister(int op, int reg, int r)
+	{
+		bytes({op, 0x43 | reg << 3, 4 * r});
+	}
+
+	static const int EAX = 0, ECX = 1;
+	void load(int reg, int r) { onRegister(0x8B, reg, r); }
+	void store(int reg, int r) { onRegister(0x89, reg, r); }
+
+	// add qword [r12 + steps], k
+	void addSteps(int k)
+	{
+		bytes({0x49, 0x81, 0x44, 0x24, (int)offsetof(JitContext, steps)});
+		dword(k);
+	}
+
+	// jcc rel32 with its displacement left to patch, returns the displacement's offset
+	size_t jumpIf(int condition)
+	{
+		bytes({0x0F, condition});
+		dword(0);
+		return used - 4;
+	}
+	static const int JE = 0x84, JNE = 0x85, JAE = 0x83, JG = 0x8F;
+
+	/*
+		trampoline(context, block): saves the registers the translated code lives in, loads them from
+		the context and jumps to the block; exits come back with the next instruction in eax
+	*/
+	void emitTrampoline()
+	{
+		bytes({0x53, 0x41, 0x54, 0x41, 0x56, 0x41, 0x57}); // push rbx, r12, r14, r15
+		bytes({0x49, 0x89, 0xFC});						   // mov r12, rdi
+		bytes({0x48, 0x8B, 0x1F});						   // mov rbx, [rdi]
+		bytes({0x4C, 0x8B, 0x77, (int)offsetof(JitContext, data)});
+		bytes({0x4C, 0x8B, 0x7F, (int)offsetof(JitContext, dirtyBits)});
+		bytes({0xFF, 0xE6}); // jmp rsi
+		exitOffset = used;
+		bytes({0x41, 0x5F, 0x41, 0x5E, 0x41, 0x5C, 0x5B, 0xC3}); // pop r15, r14, r12, rbx; ret
+	}
+
+	// back to runJit, to go on at instruction pc
+	void emitReturn(int pc)
+	{
+		byte(0xB8); // mov eax, pc
+		dword(pc);
+		byte(0xE9);
+		dword(0);
+		patch(used - 4, exitOffset);
+	}
+
+	/*
+		leave the block for instruction pc: straight to its translation if there is one and the steps
+		are within the budget, else back to runJit
+	*/
+	void emitExit(int pc, int n)
+	{
+		bytes({0x49, 0x8B, 0x44, 0x24, (int)offsetof(JitContext, steps)}); // mov rax, [r12 + steps]
+		bytes({0x49, 0x3B, 0x44, 0x24, (int)offsetof(JitContext, stop)});  // cmp rax, [r12 + stop]
+		size_t over = jumpIf(JG);
+		if (entry[pc] >= 0)
+		{
+			byte(0xE9);
+			dword(0);
+			patch(used - 4, entry[pc]);
+		}
+		else
+		{
+			if (pc < n)
+				waiting[pc].push_back(used);
+			emitReturn(pc);
+		}
+		patch(over, used);
+		emitReturn(pc);
+	}
+
+	/*
+		translate the block starting at pc, up to its branch or jump, the end of the program or
+		BLOCK_INSTRUCTIONS; dataStart and MAX bound the lw/sw addresses as locateAddress does
+	*/
+	void translate(const std::vector<Instruction> &program, int pc, int dataStart, int MAX)
+	{
+		const int n = program.size();
+		if (used + BLOCK_BYTES > ARENA_BYTES)
+			start(n);
+		const int begin = used;
+		entry[pc] = begin;
+
+		struct Fault
+		{
+			size_t jump[2]; // the alignment and the range checks
+			int at, started;
+		};
+		std::vector<Fault> faults;
+
+		int i = pc;
+		for (;; ++i)
+		{
+			const Instruction &ins = program[i];
+			const int k = i - pc + 1;
+			switch (ins.op)
+			{
+			case Opcode::add:
+			case Opcode::sub:
+			case Opcode::mul:
+				load(EAX, ins.r2);
+				if (ins.op == Opcode::mul)
+					byte(0x0F); // imul
+				onRegister(ins.op == Opcode::add ? 0x03 : ins.op == Opcode::sub ? 0x2B : 0xAF, EAX, ins.r3);
+				store(EAX, ins.r1);
+				break;
+			case Opcode::slt:
+				bytes({0x31, 0xC9}); // xor ecx, ecx
+				load(EAX, ins.r2);
+				onRegister(0x3B, EAX, ins.r3);
+				bytes({0x0F, 0x9C, 0xC1}); // setl cl
+				store(ECX, ins.r1);
+				break;
+			case Opcode::addi:
+				load(EAX, ins.r2);
+				byte(0x05); // add eax, imm
+				dword(ins.imm);
+				store(EAX, ins.r1);
+				break;
+			case Opcode::lw:
+			case Opcode::sw:
+			{
+				Fault fault;
+				fault.at = i, fault.started = k;
+				load(EAX, ins.r2);
+				byte(0x05);
+				dword(ins.imm);
+				bytes({0xA8, 0x03}); // test al, 3
+				fault.jump[0] = jumpIf(JNE);
+				bytes({0x89, 0xC2, 0x81, 0xEA}); // mov edx, eax; sub edx, dataStart
+				dword(dataStart);
+				bytes({0x81, 0xFA}); // cmp edx, MAX - dataStart
+				dword(MAX - dataStart);
+				fault.jump[1] = jumpIf(JAE);
+				faults.push_back(fault);
+				if (ins.op == Opcode::lw)
+				{
+					bytes({0x41, 0x8B, 0x0C, 0x06}); // mov ecx, [r14 + rax]
+					store(ECX, ins.r1);
+				}
+				else
+				{
+					load(ECX, ins.r1);
+					bytes({0x41, 0x89, 0x0C, 0x06});		  // mov [r14 + rax], ecx
+					bytes({0xC1, 0xE8, 0x0C, 0x49, 0x0F, 0xAB, 0x07}); // shr eax, 12; bts [r15], rax
+				}
+				break;
+			}
+			case Opcode::beq:
+			case Opcode::bne:
+			{
+				addSteps(k);
+				load(EAX, ins.r1);
+				onRegister(0x3B, EAX, ins.r2);
+				size_t taken = jumpIf(ins.op == Opcode::beq ? JE : JNE);
+				emitExit(i + 1, n);
+				patch(taken, used);
+				emitExit(ins.target, n);
+				break;
+			}
+			case Opcode::j:
+				addSteps(k);
+				emitExit(ins.target, n);
+				break;
+			default:
+				break;
+			}
+			if (isBranch(ins.op))
+				break;
+			if (i + 1 == n || k == BLOCK_INSTRUCTIONS)
+			{
+				addSteps(k);
+				emitExit(i + 1, n);
+				break;
+			}
+		}
+
+		// an lw/sw outside the data segment leaves with ~pc, counting the instructions started up to it
+		for (const Fault &fault : faults)
+		{
+			patch(fault.jump[0], used);
+			patch(fault.jump[1], used);
+			addSteps(fault.started);
+			emitReturn(~fault.at);
+		}
+
+		// exits translated earlier to this block now jump here
+		for (int at : waiting[pc])
+		{
+			arena[at] = 0xE9; // the mov eax, pc becomes jmp
+			patch(at + 1, begin);
+		}
+		waiting[pc].clear();
+	}
+};
+
+/*
+	run the simulator's program from PCcurr as runThreaded does, translating the blocks entered
+	jit.hotThreshold times; steps counts the instructions started and PCcurr is left on a faulting lw/sw.
+	Bounded runs also stop once limit instructions have run, with PCcurr on the next one
+*/
+template <bool Bounded = false, typename Simulator>
+exit_code runJit(Simulator &m, JitCode &jit, ThreadedCode &threaded, long long &steps, long long limit = 0)
+{
+	const std::vector<Instruction> &program = m.program->instructions;
+	const int n = program.size();
+	if (!jit.ready(n))
+		return runThreaded<false, true, Bounded>(m, threaded, steps, limit);
+
+	int *const r = m.registers;
+	JitContext context = {m.registers, m.data, m.dirtyPages.bits, 0, Bounded ? limit - JitCode::BLOCK_INSTRUCTIONS : LLONG_MAX};
+	int pc = m.PCcurr;
+	exit_code code = SUCCESS;
+	while (pc < n)
+	{
+		if (Bounded && context.steps == limit)
+			break;
+		if (jit.entry[pc] < 0 && ++jit.heat[pc] >= jit.hotThreshold)
+			jit.translate(program, pc, m.dataStart, m.MAX);
+		if (jit.entry[pc] >= 0 && context.steps <= context.stop)
+		{
+			pc = jit.run(context, pc);
+			if (pc < 0)
+			{
+				pc = ~pc;
+				code = INVALID_ADDRESS;
+				break;
+			}
+			continue;
+		}
+
+		// interpret the block up to its branch or jump, or to the end of the budget
+		for (bool branched = false; !branched && pc < n && !(Bounded && context.steps == limit);)
+		{
+			const Instruction &ins = program[pc];
+			++context.steps;
+			int next = pc + 1, address;
+			switch (ins.op)
+			{
+			case Opcode::add:
+				r[ins.r1] = r[ins.r2] + r[ins.r3];
+				break;
+			case Opcode::sub:
+				r[ins.r1] = r[ins.r2] - r[ins.r3];
+				break;
+			case Opcode::mul:
+				r[ins.r1] = r[ins.r2] * r[ins.r3];
+				break;
+			case Opcode::slt:
+				r[ins.r1] = r[ins.r2] < r[ins.r3];
+				break;
+			case Opcode::addi:
+				r[ins.r1] = r[ins.r2] + ins.imm;
+				break;
+			case Opcode::beq:
+				if (r[ins.r1] == r[ins.r2])
+					next = ins.target;
+				break;
+			case Opcode::bne:
+				if (r[ins.r1] != r[ins.r2])
+					next = ins.target;
+				break;
+			case Opcode::j:
+				next = ins.target;
+				break;
+			case Opcode::lw:
+			case Opcode::sw:
+				address = m.locateAddress(ins);
+				if (address < 0)
+				{
+					code = INVALID_ADDRESS;
+					goto done;
+				}
+				if (ins.op == Opcode::lw)
+					r[ins.r1] = m.data[address];
+				else
+				{
+					m.data[address] = r[ins.r1];
+					m.dirtyPages.mark(address);
+				}
+				break;
+			default:
+				break;
+			}
+			branched = isBranch(ins.op);
+			pc = next;
+		}
+	}
+done:
+	m.PCcurr = m.PCnext = pc;
+	steps += context.steps;
+	return code;
+}
+
+#endif
@@ -0,0 +1,162 @@
+/**
+ * @file Lexer.hpp
+ * @brief Zero-copy lexing of assembly source: the file is mapped once and every token is a view into it
+ *
+ */
+
+#ifndef __LEXER_HPP__
+#define __LEXER_HPP__
+
+#include <array>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <climits>
+#include <cctype>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// mnemonic followed by up to three operands, missing ones are empty
+typedef std::array<std::string_view, 4> Command;
+
+// the whole source text, mapped read-only when possible and read into memory otherwise
+struct SourceText
+{
+	void *mapped = nullptr;
+	size_t length = 0;
+	std::string buffer;
+	std::string fileName;
+
+	SourceText() = default;
+	SourceText(const SourceText &) = delete;
+	SourceText &operator=(const SourceText &) = delete;
+
+	SourceText(SourceText &&other) : mapped(other.mapped), length(other.length), buffer(std::move(other.buffer)), fileName(std::move(other.fileName))
+	{
+		other.mapped = nullptr;
+		other.length = 0;
+	}
+
+	SourceText &operator=(SourceText &&other)
+	{
+		if (this != &other)
+		{
+			close();
+			mapped = other.mapped;
+			length = other.length;
+			buffer = std::move(other.buffer);
+			fileName = std::move(other.fileName);
+			other.mapped = nullptr;
+			other.length = 0;
+		}
+		return *this;
+	}
+
+	~SourceText()
+	{
+		close();
+	}
+
+	// returns false if the file cannot be opened
+	bool open(const char *fileName)
+	{
+		close();
+		int fd = ::open(fileName, O_RDONLY);
+		if (fd < 0)
+			return false;
+		this->fileName = fileName;
+		struct stat st;
+		if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0)
+		{
+			void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (p != MAP_FAILED)
+			{
+				madvise(p, st.st_size, MADV_SEQUENTIAL);
+				mapped = p;
+				length = st.st_size;
+				::close(fd);
+				return true;
+			}
+		}
+		// empty files, pipes and anything else mmap refuses
+		char chunk[1 << 16];
+		for (ssize_t n; (n = ::read(fd, chunk, sizeof(chunk))) > 0;)
+			buffer.append(chunk, n);
+		::close(fd);
+		return true;
+	}
+
+	void close()
+	{
+		if (mapped)
+			munmap(mapped, length);
+		mapped = nullptr;
+		length = 0;
+		buffer.clear();
+		fileName.clear();
+	}
+
+	std::string_view text() const
+	{
+		return mapped ? std::string_view(static_cast<const char *>(mapped), length) : std::string_view(buffer);
+	}
+};
+
+// cut the next line off the front of text, like getline the last line needs no '\n'
+inline std::string_view nextLine(std::string_view &text)
+{
+	size_t end = text.find('\n');
+	std::string_view line = text.substr(0, end);
+	text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+	return line;
+}
+
+inline bool isSeparator(char c)
+{
+	return c == ' ' || c == ',' || c == '\t';
+}
+
+// split a line at ", \t" dropping empty tokens, the same tokens boost::char_separator<char>(", \t") gave
+inline void tokenize(std::string_view line, std::vector<std::string_view> &tokens)
+{
+	tokens.clear();
+	const char *p = line.data(), *end = p + line.size();
+	while (true)
+	{
+		while (p != end && isSeparator(*p))
+			++p;
+		if (p == end)
+			return;
+		const char *start = p;
+		while (p != end && !isSeparator(*p))
+			++p;
+		tokens.emplace_back(start, p - start);
+	}
+}
+
+// stoi without the exceptions: leading spaces, an optional sign and at least one digit, trailing text ignored
+inline bool parseInt(std::string_view s, int &value)
+{
+	size_t i = 0;
+	while (i < s.size() && isspace((unsigned char)s[i]))
+		++i;
+	bool negative = i < s.size() && s[i] == '-';
+	if (i < s.size() && (s[i] == '-' || s[i] == '+'))
+		++i;
+	if (i == s.size() || !isdigit((unsigned char)s[i]))
+		return false;
+	long long v = 0;
+	for (; i < s.size() && isdigit((unsigned char)s[i]); ++i)
+		if ((v = v * 10 + (s[i] - '0')) > (long long)INT_MAX + 1)
+			return false;
+	if (negative)
+		v = -v;
+	if (v > INT_MAX)
+		return false;
+	value = v;
+	return true;
+}
+
+#endif
@@ -0,0 +1,306 @@
+/**
+ * @file MachineCode.hpp
+ * @brief Loader for 32-bit MIPS machine code (ELF32 or raw, either byte order) with a table driven
+ * decoder into the same Instruction records the assembly parser produces
+ *
+ * Only the simulated subset decodes (add, sub, mul, slt, addi, beq, bne, j, lw, sw and their unsigned
+ * forms); branches have no delay slot, like the assembly programs. Instructions whose destination is
+ * $zero have no effect on MIPS and decode as a nop, which locks no register in the pipelines. A raw
+ * image must hold whole words.
+ */
+
+#ifndef __MACHINE_CODE_HPP__
+#define __MACHINE_CODE_HPP__
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <list>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Instruction.hpp"
+
+enum class MachineFormat
+{
+	none,
+	elf,
+	rawBig,
+	rawLittle
+};
+
+// why a program cannot run, found while decoding it
+enum class MachineError
+{
+	none,
+	malformed,	 // not an ELF32 MIPS image, no code in it or a partial word
+	unsupported, // a word outside the simulated subset
+	badTarget	 // a branch or jump leaving the code
+};
+
+// raw images are placed where SPIM and MARS put .text
+static const uint32_t RAW_TEXT_BASE = 0x00400000;
+
+// ELF by its magic, raw machine code by the .bin extension, big endian unless it ends in .el.bin
+inline MachineFormat machineFormat(const std::string &fileName, std::string_view bytes)
+{
+	auto endsWith = [&](std::string_view suffix)
+	{
+		return fileName.size() >= suffix.size() && fileName.compare(fileName.size() - suffix.size(), suffix.size(), suffix) == 0;
+	};
+	if (bytes.substr(0, 4) == "\x7f"
+							  "ELF")
+		return MachineFormat::elf;
+	if (endsWith(".el.bin"))
+		return MachineFormat::rawLittle;
+	if (endsWith(".bin"))
+		return MachineFormat::rawBig;
+	return MachineFormat::none;
+}
+
+// operand layout of an encoding
+enum class Encoding : uint8_t
+{
+	none,
+	rType,	   // rd = rs op rt
+	immediate, // rt = rs + simm
+	branch,	   // compare rs, rt and go to pc + 4 + 4 * simm
+	jump,	   // go to the 26 bit word index inside the current 256 MiB region
+	memory	   // rt <-> data[rs + simm]
+};
+
+struct Decoding
+{
+	Opcode op = Opcode::invalid;
+	Encoding encoding = Encoding::none;
+	const char *name = nullptr;
+};
+
+typedef std::array<Decoding, 64> DecodeTable;
+
+// primary opcode, bits 31..26
+constexpr DecodeTable primaryTable()
+{
+	DecodeTable t{};
+	t[0x02] = {Opcode::j, Encoding::jump, "j"};
+	t[0x04] = {Opcode::beq, Encoding::branch, "beq"};
+	t[0x05] = {Opcode::bne, Encoding::branch, "bne"};
+	t[0x08] = {Opcode::addi, Encoding::immediate, "addi"};
+	t[0x09] = {Opcode::addi, Encoding::immediate, "addiu"};
+	t[0x23] = {Opcode::lw, Encoding::memory, "lw"};
+	t[0x2b] = {Opcode::sw, Encoding::memory, "sw"};
+	return t;
+}
+
+// function field, bits 5..0, of SPECIAL (opcode 0)
+constexpr DecodeTable specialTable()
+{
+	DecodeTable t{};
+	t[0x20] = {Opcode::add, Encoding::rType, "add"};
+	t[0x21] = {Opcode::add, Encoding::rType, "addu"};
+	t[0x22] = {Opcode::sub, Encoding::rType, "sub"};
+	t[0x23] = {Opcode::sub, Encoding::rType, "subu"};
+	t[0x2a] = {Opcode::slt, Encoding::rType, "slt"};
+	return t;
+}
+
+// function field of SPECIAL2 (opcode 0x1c)
+constexpr DecodeTable special2Table()
+{
+	DecodeTable t{};
+	t[0x02] = {Opcode::mul, Encoding::rType, "mul"};
+	return t;
+}
+
+static constexpr DecodeTable PRIMARY = primaryTable(), SPECIAL = specialTable(), SPECIAL2 = special2Table();
+
+inline const Decoding &decodingOf(uint32_t word)
+{
+	uint32_t opcode = word >> 26;
+	if (opcode == 0x00)
+		return SPECIAL[word & 0x3f];
+	if (opcode == 0x1c)
+		return SPECIAL2[word & 0x3f];
+	return PRIMARY[opcode];
+}
+
+// words of the code in the file's byte order
+struct CodeView
+{
+	std::string_view bytes;
+	bool bigEndian = true;
+
+	bool has(size_t offset, size_t size) const
+	{
+		return offset <= bytes.size() && size <= bytes.size() - offset;
+	}
+
+	uint32_t read(size_t offset, int size) const
+	{
+		uint32_t value = 0;
+		for (int i = 0; i < size; ++i)
+			value |= uint32_t((unsigned char)bytes[offset + i]) << 8 * (bigEndian ? size - 1 - i : i);
+		return value;
+	}
+};
+
+// code found in an ELF32 MIPS image: the .text section, else the first executable section, else the executable segment
+inline bool elfCode(std::string_view file, std::string_view &code, uint32_t &base, uint32_t &entry, bool &bigEndian)
+{
+	CodeView elf{file, true};
+	if (!elf.has(0, 52) || file[4] != 1 || (file[5] != 1 && file[5] != 2))
+		return false;
+	elf.bigEndian = bigEndian = file[5] == 2;
+	if (elf.read(18, 2) != 8) // EM_MIPS
+		return false;
+	entry = elf.read(24, 4);
+	uint32_t phoff = elf.read(28, 4), shoff = elf.read(32, 4);
+	uint32_t phentsize = elf.read(42, 2), phnum = elf.read(44, 2), shentsize = elf.read(46, 2), shnum = elf.read(48, 2), shstrndx = elf.read(50, 2);
+
+	auto take = [&](uint32_t offset, uint32_t size, uint32_t address)
+	{
+		if (!elf.has(offset, size))
+			return false;
+		code = file.substr(offset, size);
+		base = address;
+		return true;
+	};
+
+	if (shoff && shentsize >= 40 && elf.has(shoff, size_t(shnum) * shentsize) && shstrndx < shnum)
+	{
+		uint32_t names = elf.read(shoff + shstrndx * shentsize + 16, 4);
+		int executable = -1;
+		for (uint32_t i = 0; i < shnum; ++i)
+		{
+			size_t sh = shoff + size_t(i) * shentsize;
+			bool progbits = elf.read(sh + 4, 4) == 1, execinstr = elf.read(sh + 8, 4) & 4;
+			if (!progbits || !execinstr)
+				continue;
+			uint32_t name = names + elf.read(sh, 4);
+			if (elf.has(name, 6) && file.substr(name, 6) == std::string_view(".text\0", 6))
+				return take(elf.read(sh + 16, 4), elf.read(sh + 20, 4), elf.read(sh + 12, 4));
+			if (executable < 0)
+				executable = i;
+		}
+		if (executable >= 0)
+		{
+			size_t sh = shoff + size_t(executable) * shentsize;
+			return take(elf.read(sh + 16, 4), elf.read(sh + 20, 4), elf.read(sh + 12, 4));
+		}
+	}
+	if (phoff && phentsize >= 32 && elf.has(phoff, size_t(phnum) * phentsize))
+		for (uint32_t i = 0; i < phnum; ++i)
+		{
+			size_t ph = phoff + size_t(i) * phentsize;
+			if (elf.read(ph, 4) == 1 && (elf.read(ph + 24, 4) & 1)) // PT_LOAD, PF_X
+				return take(elf.read(ph + 4, 4), elf.read(ph + 16, 4), elf.read(ph + 8, 4));
+		}
+	return false;
+}
+
+/*
+	decode the machine code of an image into the program, with a listing of every word in commands
+	(views into listing) and the first word that cannot run in errorAt, returns MachineError::none
+	when the whole program can run
+*/
+inline MachineError loadMachineCode(std::string_view file, MachineFormat format, std::vector<Instruction> &program, std::vector<Command> &commands, std::vector<int> &commandLines, std::list<std::string> &listing, int &entry, int &errorAt)
+{
+	std::string_view code = file;
+	uint32_t base = RAW_TEXT_BASE, entryAddress = RAW_TEXT_BASE;
+	bool bigEndian = format != MachineFormat::rawLittle;
+	if ((format == MachineFormat::elf && !elfCode(file, code, base, entryAddress, bigEndian)) || code.size() % 4)
+		return MachineError::malformed;
+	CodeView words{code, bigEndian};
+	const int n = code.size() / 4;
+	entry = entryAddress >= base && entryAddress - base < 4u * n && entryAddress % 4 == 0 ? (entryAddress - base) / 4 : 0;
+
+	// the listing is built first and cut into views once it stops growing
+	std::string text;
+	std::vector<std::array<std::pair<uint32_t, uint32_t>, 4>> tokens(n);
+	auto token = [&](int i, int k, const std::string &s)
+	{
+		tokens[i][k] = {text.size(), s.size()};
+		text += s;
+	};
+	auto reg = [](uint32_t r)
+	{
+		return "$" + std::to_string(r);
+	};
+	auto hex = [](uint32_t value)
+	{
+		char s[16];
+		snprintf(s, sizeof(s), "0x%08x", value);
+		return std::string(s);
+	};
+
+	MachineError error = MachineError::none;
+	program.assign(n, Instruction());
+	for (int i = 0; i < n; ++i)
+	{
+		const uint32_t word = words.read(4 * i, 4), address = base + 4 * i;
+		const uint32_t rs = word >> 21 & 31, rt = word >> 16 & 31, rd = word >> 11 & 31;
+		const int simm = int16_t(word & 0xffff);
+		const Decoding &d = decodingOf(word);
+		Instruction &ins = program[i];
+		ins.op = d.op;
+		MachineError problem = MachineError::none;
+		switch (d.encoding)
+		{
+		case Encoding::rType:
+			ins.r1 = rd, ins.r2 = rs, ins.r3 = rt;
+			token(i, 0, d.name), token(i, 1, reg(rd)), token(i, 2, reg(rs)), token(i, 3, reg(rt));
+			break;
+		case Encoding::immediate:
+			ins.r1 = rt, ins.r2 = rs, ins.imm = simm;
+			token(i, 0, d.name), token(i, 1, reg(rt)), token(i, 2, reg(rs)), token(i, 3, std::to_string(simm));
+			break;
+		case Encoding::memory:
+			ins.r1 = rt, ins.r2 = rs, ins.imm = simm;
+			token(i, 0, d.name), token(i, 1, reg(rt)), token(i, 2, std::to_string(simm) + "(" + reg(rs) + ")");
+			break;
+		case Encoding::branch:
+			ins.r1 = rs, ins.r2 = rt, ins.target = i + 1 + simm;
+			token(i, 0, d.name), token(i, 1, reg(rs)), token(i, 2, reg(rt)), token(i, 3, hex(address + 4 + 4 * simm));
+			break;
+		case Encoding::jump:
+		{
+			uint32_t target = ((address + 4) & 0xf0000000) | (word & 0x03ffffff) << 2;
+			ins.target = (int)((target - base) / 4);
+			token(i, 0, d.name), token(i, 1, hex(target));
+			break;
+		}
+		default:
+			// sll $zero, $zero, 0 is the canonical nop
+			if (word == 0)
+			{
+				ins.op = Opcode::nop;
+				token(i, 0, "nop");
+				break;
+			}
+			problem = MachineError::unsupported;
+			token(i, 0, ".word"), token(i, 1, hex(word));
+			break;
+		}
+		if ((d.encoding == Encoding::branch || d.encoding == Encoding::jump) && (ins.target < 0 || ins.target > n || (d.encoding == Encoding::jump && base % 4)))
+			problem = MachineError::badTarget;
+		// writes to $zero are dropped on MIPS, sw is the only write that does not go to a register
+		if (problem == MachineError::none && ins.r1 == 0 && d.encoding != Encoding::branch && d.encoding != Encoding::jump && ins.op != Opcode::sw)
+			ins = Instruction{Opcode::nop};
+		if (problem != MachineError::none && error == MachineError::none)
+			error = problem, errorAt = i;
+	}
+
+	listing.push_back(std::move(text));
+	std::string_view all = listing.back();
+	commands.assign(n, Command());
+	commandLines.resize(n);
+	for (int i = 0; i < n; ++i)
+	{
+		for (int k = 0; k < 4; ++k)
+			commands[i][k] = all.substr(tokens[i][k].first, tokens[i][k].second);
+		commandLines[i] = i + 1;
+	}
+	return error;
+}
+
+#endif
@@ -0,0 +1,180 @@
+/**
+ * @file Parser.hpp
+ * @brief Two pass parser shared by the models: line aligned chunks of the source are parsed
+ * concurrently, then their commands and label definitions are merged in source order
+ *
+ */
+
+#ifndef __PARSER_HPP__
+#define __PARSER_HPP__
+
+#include <algorithm>
+#include <list>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "Lexer.hpp"
+
+// below these sizes per thread the work is done serially
+static const size_t PARSE_BYTES_PER_THREAD = 1 << 20;
+static const size_t DECODE_COMMANDS_PER_THREAD = 1 << 16;
+
+// threads worth starting for `work` units when each should get at least `minPerThread`
+inline unsigned workerThreads(size_t work, size_t minPerThread)
+{
+	size_t cores = std::max(1u, std::thread::hardware_concurrency());
+	return std::max<size_t>(1, std::min(cores, work / minPerThread));
+}
+
+// run f(begin, end) over [0, n) split into one contiguous range per thread, the caller takes the first range
+template <typename F>
+void parallelFor(size_t n, unsigned threads, F f)
+{
+	if (threads <= 1)
+	{
+		f(size_t(0), n);
+		return;
+	}
+	std::vector<std::thread> pool;
+	for (unsigned t = 1; t < threads; ++t)
+		pool.emplace_back(f, n * t / threads, n * (t + 1) / threads);
+	f(size_t(0), n / threads);
+	for (auto &thread : pool)
+		thread.join();
+}
+
+// commands of one line aligned piece of the source, with line numbers and label indices local to it
+struct ParsedChunk
+{
+	std::vector<Command> commands;
+	std::vector<int> commandLines;
+	std::vector<std::pair<std::string_view, int>> labels; // in order of definition
+	std::list<std::string> joinedOperands;
+	std::vector<std::string_view> tokens;
+	int lines = 0;
+
+	void defineLabel(std::string_view label)
+	{
+		labels.emplace_back(label, commands.size());
+	}
+
+	// parse the command assuming correctly formatted MIPS instruction (or label)
+	void parseCommand(std::string_view line)
+	{
+		// strip until before the comment begins
+		line = line.substr(0, line.find('#'));
+		std::vector<std::string_view> &command = tokens;
+		tokenize(line, command);
+		// empty line or a comment only line
+		if (command.empty())
+			return;
+		else if (command.size() == 1)
+		{
+			defineLabel(command[0].back() == ':' ? command[0].substr(0, command[0].size() - 1) : "?");
+			return;
+		}
+		else if (command[0].back() == ':')
+		{
+			defineLabel(command[0].substr(0, command[0].size() - 1));
+			command.erase(command.begin());
+		}
+		else if (command[0].find(':') != std::string_view::npos)
+		{
+			size_t idx = command[0].find(':');
+			defineLabel(command[0].substr(0, idx));
+			command[0] = command[0].substr(idx + 1);
+		}
+		else if (command[1][0] == ':')
+		{
+			defineLabel(command[0]);
+			command[1] = command[1].substr(1);
+			if (command[1].empty())
+				command.erase(command.begin(), command.begin() + 2);
+			else
+				command.erase(command.begin(), command.begin() + 1);
+		}
+		if (command.empty())
+			return;
+		Command parsed;
+		for (int i = 0; i < 4 && i < (int)command.size(); ++i)
+			parsed[i] = command[i];
+		if (command.size() > 4)
+		{
+			// extra operands are joined into the last one, which then is not a slice of the source
+			std::string joined(command[3]);
+			for (int i = 4; i < (int)command.size(); ++i)
+				joined.append(" ").append(command[i]);
+			joinedOperands.push_back(std::move(joined));
+			parsed[3] = joinedOperands.back();
+		}
+		commands.push_back(parsed);
+	}
+
+	void parse(std::string_view text)
+	{
+		while (!text.empty())
+		{
+			parseCommand(nextLine(text));
+			commandLines.resize(commands.size(), ++lines);
+		}
+	}
+};
+
+/*
+	parse the whole source, the result is the same as parsing it line by line:
+	commands and their line numbers are concatenated in source order and a label
+	defined more than once, in the same chunk or in different ones, resolves to -1
+*/
+inline void parseSource(std::string_view text, std::vector<Command> &commands, std::vector<int> &commandLines, std::unordered_map<std::string_view, int> &address, std::list<std::string> &joinedOperands, unsigned threads = 0)
+{
+	if (threads == 0)
+		threads = workerThreads(text.size(), PARSE_BYTES_PER_THREAD);
+
+	// first pass: cut at the line ending after every 1/threads of the text and parse the chunks concurrently
+	std::vector<std::string_view> pieces;
+	for (size_t begin = 0, t = 1; t <= threads; ++t)
+	{
+		size_t end = text.size() * t / threads;
+		if (end < begin)
+			end = begin;
+		if (end < text.size() && end > 0 && text[end - 1] != '\n')
+			end = std::min(text.find('\n', end), text.size() - 1) + 1;
+		pieces.push_back(text.substr(begin, end - begin));
+		begin = end;
+	}
+	std::vector<ParsedChunk> chunks(pieces.size());
+	parallelFor(pieces.size(), threads, [&](size_t begin, size_t end)
+				{
+		for (size_t i = begin; i < end; ++i)
+			chunks[i].parse(pieces[i]); });
+
+	// second pass: merge in source order, offsetting the chunk local command and line numbers
+	size_t total = commands.size();
+	for (auto &chunk : chunks)
+		total += chunk.commands.size();
+	commands.reserve(total);
+	commandLines.reserve(total);
+	int lineOffset = 0;
+	for (auto &chunk : chunks)
+	{
+		int commandOffset = commands.size();
+		for (auto &label : chunk.labels)
+		{
+			auto it = address.find(label.first);
+			if (it == address.end())
+				address[label.first] = commandOffset + label.second;
+			else
+				it->second = -1;
+		}
+		commands.insert(commands.end(), chunk.commands.begin(), chunk.commands.end());
+		for (int line : chunk.commandLines)
+			commandLines.push_back(lineOffset + line);
+		joinedOperands.splice(joinedOperands.end(), chunk.joinedOperands);
+		lineOffset += chunk.lines;
+	}
+}
+
+#endif
@@ -0,0 +1,141 @@
+/**
+ * @file Pipeline.hpp
+ * @brief Pieces shared by the pipeline models: latch helpers, the per cycle memory delta, the
+ * occupancy statistic, the register scoreboard and the dirty page set of data memory
+ *
+ */
+
+#ifndef __PIPELINE_HPP__
+#define __PIPELINE_HPP__
+
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include "Instruction.hpp"
+#include "AllocCounter.hpp"
+
+// bubbles (invalid latches) and the end marker carry no work through the pipeline
+template <typename Latch>
+inline bool isIdle(const Latch &latch)
+{
+	return !latch.valid || latch.command.op == Opcode::end;
+}
+
+// memory writes of the current cycle, a fixed size stand-in for unordered_map<int, int>
+struct MemoryDelta
+{
+	static const int CAPACITY = 8;
+	std::pair<int, int> entries[CAPACITY];
+	int count = 0;
+
+	int &operator[](int address)
+	{
+		for (int i = 0; i < count; ++i)
+			if (entries[i].first == address)
+				return entries[i].second;
+		entries[count] = {address, 0};
+		return entries[count++].second;
+	}
+
+	int size() const { return count; }
+	void clear() { count = 0; }
+	const std::pair<int, int> *begin() const { return entries; }
+	const std::pair<int, int> *end() const { return entries + count; }
+};
+
+// cycles spent with each number of instructions in flight, sampled at the end of every cycle
+template <int LATCHES>
+struct Occupancy
+{
+	long long cycles[LATCHES + 1] = {0};
+
+	void record(int inFlight) { ++cycles[inFlight]; }
+
+	long long total() const
+	{
+		long long n = 0;
+		for (long long c : cycles)
+			n += c;
+		return n;
+	}
+
+	double average() const
+	{
+		long long n = 0, weighted = 0;
+		for (int k = 0; k <= LATCHES; ++k)
+			n += cycles[k], weighted += k * cycles[k];
+		return n ? double(weighted) / n : 0;
+	}
+
+	void clear() { memset(cycles, 0, sizeof(cycles)); }
+};
+
+inline uint32_t registerBit(int r)
+{
+	return 1u << r;
+}
+
+// registers with writes in flight: a hazard check is one AND of the busy mask with the registers
+// read, the count of writes per register only matters when one of them is released
+struct Scoreboard
+{
+	uint32_t busy = 0;
+	int pending[32] = {0};
+	uint32_t releasing = 0; // released at the end of the cycle, no more than one write per register retires in a cycle
+
+	bool any(uint32_t regs) const { return busy & regs; }
+
+	void acquire(int r) { update(r, pending[r] + 1); }
+	void release(int r) { update(r, pending[r] - 1); }
+	void releaseAtEndOfCycle(int r) { releasing |= registerBit(r); }
+
+	void endCycle()
+	{
+		for (; releasing; releasing &= releasing - 1)
+			release(__builtin_ctz(releasing));
+	}
+
+	void update(int r, int count)
+	{
+		pending[r] = count;
+		busy = count != 0 ? busy | registerBit(r) : busy & ~registerBit(r);
+	}
+
+	void clear()
+	{
+		busy = releasing = 0;
+		memset(pending, 0, sizeof(pending));
+	}
+};
+
+// 4 KiB pages of a data memory of WORDS ints written since the last clear, so a reset zeroes only those
+template <int WORDS>
+struct DirtyPages
+{
+	static const int PAGE_WORDS = 1024;
+	static const int PAGES = WORDS / PAGE_WORDS;
+	uint64_t bits[(PAGES + 63) / 64] = {0};
+
+	void mark(int word)
+	{
+		int page = word / PAGE_WORDS;
+		bits[page / 64] |= 1ull << (page % 64);
+	}
+
+	// true if the page holding this word was written
+	bool dirty(int word) const
+	{
+		int page = word / PAGE_WORDS;
+		return bits[page / 64] >> (page % 64) & 1;
+	}
+
+	void clear(int *data)
+	{
+		for (int w = 0; w < (PAGES + 63) / 64; ++w)
+			for (uint64_t b = bits[w]; b; b &= b - 1)
+				memset(data + (64 * w + __builtin_ctzll(b)) * PAGE_WORDS, 0, PAGE_WORDS * sizeof(int));
+		memset(bits, 0, sizeof(bits));
+	}
+};
+
+#endif
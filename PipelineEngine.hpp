@@ -0,0 +1,1403 @@
+/**
+ * @file PipelineEngine.hpp
+ * @author Mallika Prabhakar and Sayam Sethi
+ * @brief The pipeline models as one engine, specialized at compile time by its template arguments
+ *
+ * Depth is the number of stages on the longest path: 5 for the classic pipeline, 9 for the one
+ * whose register type instructions take a separate 7 stage path (SplitPaths) past the memory
+ * stages. Forwarding::none stalls a reader in register read until the producer has written back;
+ * Forwarding::bypass hands results to later instructions without the register file round trip.
+ */
+
+#ifndef __PIPELINE_ENGINE_HPP__
+#define __PIPELINE_ENGINE_HPP__
+
+#include <unordered_map>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <exception>
+#include <iostream>
+#include <queue>
+#include <atomic>
+#include <memory>
+#include <cstdio>
+#include <climits>
+#include "Pipeline.hpp"
+#include "Program.hpp"
+#include "ThreadedCode.hpp"
+#include "Jit.hpp"
+
+enum class Forwarding
+{
+	none,
+	bypass
+};
+
+template <int Depth, bool SplitPaths, Forwarding Policy>
+struct PipelineEngine
+{
+	static_assert((Depth == 5 && !SplitPaths) || (Depth == 9 && SplitPaths), "the engine implements the 5 stage and the split 7/9 stage pipelines");
+
+	static constexpr bool FORWARDING = Policy == Forwarding::bypass;
+	// bubbles fetched after a taken branch or jump, until its target is known
+	static const int BRANCH_STALLS = Depth == 5 ? 2 : 5;
+	static const int JUMP_STALLS = Depth == 5 ? 1 : 3;
+
+	int registers[32] = {0}, PCcurr = 0, PCnext = 0;
+	static const int MAX = (1 << 20);
+	int data[MAX >> 2] = {0};
+	DirtyPages<(MAX >> 2)> dirtyPages; // pages of data written since the last reset
+	int dataStart = 0; // lowest byte address lw/sw may touch, the program occupies the words below
+	std::shared_ptr<const Program> program; // read only, may be shared with other simulators
+	std::vector<int> commandCount;
+	ThreadedCode threaded; // the program as threaded code, for executeCommandsFunctional
+	ThreadedCode bounded;  // and as the unfused threaded code of fastForward where there is no jit
+	JitCode jit; // hot blocks translated to host code, for executeCommandsJit and fastForward
+	std::ostream *out = &std::cout, *err = &std::cerr; // where the registers and the exit report go
+
+	/*
+		event driven output: a cycle that leaves the registers as last printed and memory untouched
+		is idle, a run of them is printed as one "(n idle cycles)" line when the next change comes,
+		or as the n identical cycles of the normal output if expandIdle is set. Only the output is
+		compressed: the stages still run every idle cycle, a stall moves bubbles and locks each one
+	*/
+	bool skipIdle = false, expandIdle = false;
+	static const int IDLE_FLUSH = 1024; // a pipeline that never changes again still shows progress
+	int printed[32] = {0};
+	int idleCycles = 0;
+	MemoryDelta memoryDelta;
+
+	bool proceed = !SplitPaths;
+
+	bool branchStall = false;
+
+	int noOfStalls = 0;
+
+	Scoreboard scoreboard; // registers locked by a write in flight
+
+	// results forwarded to later instructions ahead of write back (5 stage, bypass)
+	int latch_reg[32] = {0};
+
+	bool endPipeline = false;
+
+	/*
+		instructions still to fetch before fetching as if the program had ended, negative for no limit;
+		the cycles spent fetching the last `measured` of them are counted in measuredCycles
+	*/
+	long long fetchBudget = -1;
+	long long measured = 0, measuredCycles = 0;
+	// split pipeline: a branch still unresolved when its stalls run out is fetched again, not charged to the budget
+	int unresolvedBranch = -1;
+
+	/*
+		timing only run (TimingMemo.hpp): whether the branch at each PC is taken, or the lw/sw there
+		faults, as a functional run found; a fetched beq/bne/lw/sw carries it in imm and is resolved by
+		it, so no value in the pipeline matters and data memory is left alone
+	*/
+	const char *outcomes = nullptr;
+
+	// PC of an lw/sw whose address was outside the data segment, the run stops once it reaches memory
+	int faultAt = -1;
+
+	// instructions in the latches, counted as they are fetched and retired so that idling is seen at once
+	static const int LATCHES = SplitPaths ? 10 : 4;
+	int inFlight = 0;
+	Occupancy<LATCHES> occupancy;
+
+	// write back of the split pipeline retires the register writes in fetch order
+	int insNo = 1;
+	int lastWrite = 0;
+	bool proceedRtype = false;
+	bool proceedItype = false;
+	bool endRtype = false;
+	bool endItype = false;
+
+
+	// pipeline latches are plain records, a bubble is a latch whose valid bit is unset, insNo only matters on split paths;
+	// pc, of the instruction, is only read when an lw/sw faults
+
+    struct IF{
+        bool valid = false;
+        Instruction command;
+        int insNo = 0;
+        int pc = 0;
+    };
+
+    struct ID{
+        bool valid = false;
+        Instruction command;
+        int insNo = 0;
+        int pc = 0;
+    };
+
+    struct RR{
+        bool valid = false;
+        Instruction command;
+        int insNo = 0;
+        int pc = 0;
+    };
+
+    struct EX{
+        bool valid = false;
+        Instruction command;
+		int s1_val = 0;
+		int s2_val = 0;
+        int insNo = 0;
+        int pc = 0;
+    };
+
+    struct MEM{
+        bool valid = false;
+        Instruction command;
+        int computed_value = 0;
+		int s1_val = 0;
+		int s2_val = 0;
+        int insNo = 0;
+        int pc = 0;
+    };
+
+    struct WB{
+        bool valid = false;
+        Instruction command;
+        int memory_value = 0;
+		int computed_value = 0;
+		int s1_val = 0;
+		int s2_val = 0;
+        int insNo = 0;
+    };
+
+	static_assert(std::is_trivially_copyable<EX>::value && std::is_trivially_copyable<MEM>::value && std::is_trivially_copyable<WB>::value, "latches must stay plain records");
+
+
+	// 5 stage latches, double buffered: the stages read the current set and fill the next one
+	struct FiveStageLatches{
+		ID id;
+		EX ex;
+		MEM mem;
+		WB wb;
+	};
+	FiveStageLatches fiveStage[2];
+	int current = 0;
+
+	FiveStageLatches &now(){ return fiveStage[current]; }
+	FiveStageLatches &next(){ return fiveStage[current ^ 1]; }
+	const FiveStageLatches &now() const { return fiveStage[current]; }
+
+	// split path latches
+    IF if2;
+	ID id1;
+    ID id2;
+    RR rr;
+	EX exItype;
+    EX exRtype;
+	MEM mem1;
+    MEM mem2;
+	WB wbItype;
+	WB wbRtype;
+
+
+
+	// constructor to load and verify the program
+	PipelineEngine(SourceText &&text) : PipelineEngine(std::make_shared<const Program>(std::move(text))) {}
+
+	// constructor to run a program that is already loaded
+	PipelineEngine(std::shared_ptr<const Program> loaded) : program(std::move(loaded))
+	{
+		startProgram();
+	}
+
+	/*
+		load another program into this simulator as if it were freshly constructed: only the data
+		pages the last run wrote are zeroed and the containers keep their capacity
+	*/
+	void reset(SourceText &&text)
+	{
+		reset(std::make_shared<const Program>(std::move(text)));
+	}
+
+	void reset(std::shared_ptr<const Program> loaded)
+	{
+		if (loaded != program)
+		{
+			threaded.clear();
+			bounded.clear();
+			jit.clear();
+		}
+		program = std::move(loaded);
+		memset(registers, 0, sizeof(registers));
+		dirtyPages.clear(data);
+		memoryDelta.clear();
+		idleCycles = 0;
+		occupancy.clear();
+		clearPipeline();
+		startProgram();
+	}
+
+	// empty pipeline, the registers, data and PC are kept for the next executeCommandsPipelined to start from
+	void clearPipeline()
+	{
+		proceed = !SplitPaths;
+		branchStall = false;
+		noOfStalls = 0;
+		scoreboard.clear();
+		memcpy(latch_reg, registers, sizeof(latch_reg));
+		endPipeline = false;
+		fetchBudget = -1;
+		measured = measuredCycles = 0;
+		unresolvedBranch = -1;
+		faultAt = -1;
+		inFlight = 0;
+		insNo = 1;
+		lastWrite = 0;
+		proceedRtype = proceedItype = endRtype = endItype = false;
+		fiveStage[0] = fiveStage[1] = FiveStageLatches();
+		current = 0;
+		if2 = IF();
+		id1 = id2 = ID();
+		rr = RR();
+		exItype = exRtype = EX();
+		mem1 = mem2 = MEM();
+		wbItype = wbRtype = WB();
+	}
+
+	// the data segment starts past the program, which runs from its entry
+	void startProgram()
+	{
+		PCcurr = PCnext = program->entry;
+		dataStart = 4 * program->commands.size();
+		commandCount.assign(program->commands.size(), 0);
+	}
+
+	// word index of a decoded lw/sw operand, -3 if unaligned or outside the data segment
+	int locateAddress(const Instruction &ins)
+	{
+		return locateAddress(registers[ins.r2] + ins.imm);
+	}
+
+	// one unsigned compare covers both ends of [dataStart, MAX)
+	int locateAddress(int address)
+	{
+		if ((address & 3) || unsigned(address) - unsigned(dataStart) >= unsigned(MAX - dataStart))
+			return -3;
+		return address >> 2;
+	}
+
+	/*
+		message of each exit code:
+		0: correct execution
+		1: register provided is incorrect
+		2: invalid label
+		3: unaligned or invalid address
+		4: syntax error
+		5: commands exceed memory limit
+	*/
+	static const char *exitMessage(exit_code code)
+	{
+		switch (code)
+		{
+		case 1:
+			return "Invalid register provided or syntax error in providing register\n";
+		case 2:
+			return "Label used not defined or defined too many times\n";
+		case 3:
+			return "Unaligned or invalid memory address specified\n";
+		case 4:
+			return "Syntax error encountered\n";
+		case 5:
+			return "Memory limit exceeded\n";
+		default:
+			return "";
+		}
+	}
+
+	// the source line of command i
+	void printCommand(int i)
+	{
+		*err << "Error encountered at line " << program->commandLines[i] << ":\n";
+		for (auto &s : program->commands[i])
+			*err << s << ' ';
+		*err << '\n';
+	}
+
+	// handle all exit codes
+	void handleExit(exit_code code, long long cycleCount, bool counted = true)
+	{
+		*out << '\n';
+		*err << exitMessage(code);
+		if (code != 0 && PCcurr < (int)program->commands.size())
+			printCommand(PCcurr);
+		*out << "\nFollowing are the non-zero data values:\n";
+		// pages never written are still zero
+		for (int i = 0; i < MAX / 4; ++i)
+			if (!dirtyPages.dirty(i))
+				i += dirtyPages.PAGE_WORDS - 1;
+			else if (data[i] != 0)
+				*out << 4 * i << '-' << 4 * i + 3 << std::hex << ": " << data[i] << '\n'
+						  << std::dec;
+		*out << "\nTotal number of cycles: " << cycleCount << '\n';
+		if (!counted)
+			return;
+		*out << "Count of instructions executed:\n";
+		for (int i = 0; i < (int)program->commands.size(); ++i)
+		{
+			*out << commandCount[i] << " times:\t";
+			for (auto &s : program->commands[i])
+				*out << s << ' ';
+			*out << '\n';
+		}
+	}
+
+
+
+	/*
+		true if the program cannot run, reported as it would be run: too large for memory, or with the
+		errors found while loading, the first with the exit report and the others after it
+	*/
+	bool reportLoadFailure()
+	{
+		if (program->commands.size() >= MAX / 4)
+		{
+			handleExit(MEMORY_ERROR, 0);
+			return true;
+		}
+		if (program->loadError == SUCCESS)
+			return false;
+		PCcurr = program->loadErrorAt;
+		handleExit(program->loadError, 0);
+		for (size_t i = 1; i < program->loadErrors.size(); ++i)
+		{
+			*err << exitMessage(program->loadErrors[i].second);
+			printCommand(program->loadErrors[i].first);
+		}
+		return true;
+	}
+
+	// result of a register type instruction, addi adds its immediate
+	static int alu(Opcode op, int a, int b)
+	{
+		switch (op){
+		case Opcode::sub: return a - b;
+		case Opcode::mul: return a * b;
+		case Opcode::slt: return a < b;
+		default: return a + b;
+		}
+	}
+
+	// whether a beq/bne with these operands branches, in a timing only run as tagged at fetch
+	bool taken(const Instruction &cmd, int a, int b) const
+	{
+		if (outcomes) return cmd.imm;
+		return (a == b) == (cmd.op == Opcode::beq);
+	}
+
+	// a branch or lw/sw fetched in a timing only run carries its outcome
+	void tagOutcome(Instruction &command) const
+	{
+		if (outcomes && (command.op == Opcode::beq || command.op == Opcode::bne || command.op == Opcode::lw || command.op == Opcode::sw))
+			command.imm = outcomes[PCcurr];
+	}
+
+	// an lw/sw reaching memory with an address outside the data segment stops the run, as unpipelined
+	bool faults(const MEM &mem)
+	{
+		if (!mem.valid || (mem.command.op != Opcode::lw && mem.command.op != Opcode::sw))
+			return false;
+		if (outcomes ? !mem.command.imm : mem.computed_value >= 0)
+			return false;
+		faultAt = mem.pc;
+		return true;
+	}
+
+
+	// 5 stage pipeline: IF, ID, EX, MEM, WB, every stage runs once per cycle, from the back
+
+	void instructionFetch(){
+		ID &id = next().id;
+		PCcurr = PCnext;
+		if (branchStall){
+			id.valid = false;
+			noOfStalls -= 1;
+
+			if (noOfStalls == 0) branchStall = false;
+		}
+		else if (PCcurr < program->instructions.size() && fetchBudget != 0){
+			id.valid = true;
+			id.command = program->instructions[PCcurr];
+			id.pc = PCcurr;
+			tagOutcome(id.command);
+			++inFlight;
+			if (fetchBudget > 0) --fetchBudget;
+		}
+		else{
+			id.valid = true;
+			id.command = Instruction{Opcode::end};
+		}
+	}
+
+	void instructionDecode(){
+		const ID &id = now().id;
+		EX &ex = next().ex;
+		const Instruction &cmd = id.command;
+		ex.pc = id.pc;
+
+		if (isIdle(id)){
+			ex.valid = id.valid;
+			ex.command = cmd;
+		}
+
+		// dispatch on the opcode, the enum is dense so this compiles to a jump table
+		else switch (cmd.op){
+		case Opcode::add:
+		case Opcode::sub:
+		case Opcode::mul:
+		case Opcode::slt:
+			// without forwarding the operands must have been written back
+			if constexpr (!FORWARDING){
+				if (scoreboard.any(registerBit(cmd.r2) | registerBit(cmd.r3))){
+					ex.valid = false;
+					proceed = false;
+					break;
+				}
+			}
+			ex.valid = true;
+			ex.command = cmd;
+			if constexpr (!FORWARDING) scoreboard.acquire(cmd.r1);
+			ex.s1_val = registers[cmd.r2];
+			ex.s2_val = registers[cmd.r3];
+			PCnext = PCcurr + 1;
+			break;
+
+		case Opcode::addi:
+			if constexpr (!FORWARDING){
+				if (scoreboard.any(registerBit(cmd.r2))){
+					ex.valid = false;
+					proceed = false;
+					break;
+				}
+			}
+			ex.valid = true;
+			ex.command = cmd;
+			if constexpr (!FORWARDING) scoreboard.acquire(cmd.r1);
+			ex.s1_val = registers[cmd.r2];
+			ex.s2_val = cmd.imm;
+			PCnext = PCcurr + 1;
+			break;
+
+		case Opcode::beq:
+		case Opcode::bne:
+			if constexpr (FORWARDING){
+				// compared in execute, once the operands have been forwarded
+				ex.valid = true;
+				ex.command = cmd;
+				ex.s1_val = latch_reg[cmd.r1];
+				ex.s2_val = latch_reg[cmd.r2];
+			}
+			else{
+				if (scoreboard.any(registerBit(cmd.r1) | registerBit(cmd.r2))){
+					ex.valid = false;
+					proceed = false;
+					break;
+				}
+				ex.valid = true;
+				ex.command = cmd;
+				ex.s1_val = registers[cmd.r1];
+				ex.s2_val = registers[cmd.r2];
+				PCnext = taken(cmd, ex.s1_val, ex.s2_val) ? cmd.target : PCcurr + 1;
+			}
+			branchStall = true;
+			noOfStalls = BRANCH_STALLS;
+			break;
+
+		case Opcode::j:
+			ex.valid = true;
+			ex.command = cmd;
+			ex.s1_val = 0;
+			ex.s2_val = 0;
+			PCnext = cmd.target;
+			branchStall = true;
+			noOfStalls = JUMP_STALLS;
+			break;
+
+		case Opcode::nop:
+			ex.valid = true;
+			ex.command = cmd;
+			ex.s1_val = 0;
+			ex.s2_val = 0;
+			PCnext = PCcurr + 1;
+			break;
+
+		case Opcode::lw:
+		case Opcode::sw:
+			ex.valid = true;
+			ex.command = cmd;
+			if constexpr (!FORWARDING){
+				if (cmd.op == Opcode::lw){
+					scoreboard.acquire(cmd.r1);
+				}
+			}
+			ex.s1_val = registers[cmd.r1];
+			ex.s2_val = 0;
+			PCnext = PCcurr + 1;
+
+			if constexpr (!FORWARDING){
+				if (scoreboard.any(registerBit(cmd.r2))){
+					ex.valid = false;
+					proceed = false;
+				}
+
+				else if (cmd.op == Opcode::sw && scoreboard.any(registerBit(cmd.r1))){
+					ex.valid = false;
+					proceed = false;
+				}
+			}
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	void execute(){
+		const EX &ex = now().ex;
+		MEM &mem = next().mem;
+		const Instruction &cmd = ex.command;
+		mem.valid = ex.valid;
+		mem.command = cmd;
+		mem.pc = ex.pc;
+		mem.s1_val = ex.s1_val;
+		mem.s2_val = ex.s2_val;
+
+		if (!isIdle(ex)) switch (cmd.op){
+		case Opcode::add:
+		case Opcode::sub:
+		case Opcode::mul:
+		case Opcode::slt:
+		case Opcode::addi:
+		{
+			int a = ex.s1_val, b = ex.s2_val;
+			if constexpr (FORWARDING){
+				// with forwarding the hazards are checked here, before reading the forwarded values
+				if (scoreboard.any(registerBit(cmd.r2) | (cmd.op != Opcode::addi ? registerBit(cmd.r3) : 0))){
+					mem.valid = false;
+					proceed = false;
+					break;
+				}
+				a = latch_reg[cmd.r2];
+				b = cmd.op == Opcode::addi ? ex.s2_val : latch_reg[cmd.r3];
+			}
+			mem.computed_value = alu(cmd.op, a, b);
+			// forwarded at once, nothing after execute in this cycle would see a lock on it
+			if constexpr (FORWARDING) latch_reg[cmd.r1] = mem.computed_value;
+			break;
+		}
+
+		case Opcode::beq:
+		case Opcode::bne:
+			if constexpr (FORWARDING){
+				if (scoreboard.any(registerBit(cmd.r1) | registerBit(cmd.r2))){
+					mem.valid = false;
+					proceed = false;
+					break;
+				}
+				mem.s1_val = latch_reg[cmd.r1];
+				mem.s2_val = latch_reg[cmd.r2];
+				PCnext = taken(cmd, mem.s1_val, mem.s2_val) ? cmd.target : PCcurr + 1;
+			}
+			break;
+
+		case Opcode::lw:
+		case Opcode::sw:
+			if constexpr (FORWARDING){
+				if (scoreboard.any(registerBit(cmd.r2))){
+					mem.valid = false;
+					proceed = false;
+					break;
+				}
+				mem.computed_value = locateAddress(latch_reg[cmd.r2] + cmd.imm);
+				if (cmd.op == Opcode::lw){
+					scoreboard.acquire(cmd.r1);
+				}
+			}
+			else{
+				mem.computed_value = locateAddress(cmd);
+			}
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	void memory(){
+		const MEM &mem = now().mem;
+		WB &wb = next().wb;
+		if (faults(mem)){
+			wb.valid = false;
+			return;
+		}
+		// the store belongs to the first half of the cycle
+		if (mem.valid && mem.command.op == Opcode::sw){
+			int value = mem.s1_val;
+			if constexpr (FORWARDING){
+				// the stored value is forwarded too, it may still be on its way
+				if (scoreboard.any(registerBit(mem.command.r1))){
+					wb.valid = false;
+					proceed = false;
+					return;
+				}
+				value = latch_reg[mem.command.r1];
+			}
+			if (!outcomes){
+				data[mem.computed_value] = value;
+				dirtyPages.mark(mem.computed_value);
+				memoryDelta[mem.computed_value] = value;
+			}
+		}
+
+		wb.valid = mem.valid;
+		wb.command = mem.command;
+		wb.s1_val = mem.s1_val;
+		wb.s2_val = mem.s2_val;
+		wb.computed_value = mem.computed_value;
+		wb.memory_value = 0;
+		if (mem.valid && mem.command.op == Opcode::lw){
+			if (!outcomes) wb.memory_value = data[mem.computed_value];
+			if constexpr (FORWARDING){
+				latch_reg[mem.command.r1] = wb.memory_value;
+				scoreboard.releaseAtEndOfCycle(mem.command.r1);
+			}
+		}
+	}
+
+
+	// split pipeline: IF1, IF2, ID1, ID2 and RR, then EX and WB for register type instructions
+	// or EX, MEM1, MEM2 and WB for lw and sw, the stages run once per cycle from the back
+
+    void instructionFetch1(){
+		PCcurr = PCnext;
+		if (branchStall){
+			if2.valid = false;
+			if2.insNo = -10;
+			noOfStalls -= 1;
+
+			if (noOfStalls == 0) branchStall = false;
+		}
+		else if (PCcurr < program->instructions.size() && fetchBudget != 0){
+			if2.valid = true;
+			if2.command = program->instructions[PCcurr];
+			if2.pc = PCcurr;
+			tagOutcome(if2.command);
+			if2.insNo = insNo;
+			++inFlight;
+			if (fetchBudget > 0 && PCcurr != unresolvedBranch) --fetchBudget;
+			// only instructions writing a register take a write back slot
+			if (if2.command.op == Opcode::beq || if2.command.op == Opcode::bne || if2.command.op == Opcode::j || if2.command.op == Opcode::sw || if2.command.op == Opcode::nop){if2.insNo = -10;}
+			else{
+				insNo += 1;
+			}
+		}
+		else{
+			if2.valid = true;
+			if2.command = Instruction{Opcode::end};
+			if2.insNo = -10;
+		}
+    }
+
+    void instructionFetch2(){
+		id1.valid = if2.valid;
+		id1.command = if2.command;
+		id1.insNo = if2.insNo;
+		id1.pc = if2.pc;
+
+		if (!isIdle(if2)) switch (if2.command.op){
+		case Opcode::beq:
+		case Opcode::bne:
+			branchStall = true;
+			noOfStalls = BRANCH_STALLS;
+			unresolvedBranch = PCcurr;
+			break;
+		case Opcode::j:
+			branchStall = true;
+			noOfStalls = JUMP_STALLS;
+			break;
+		case Opcode::addi:
+		case Opcode::add:
+		case Opcode::sub:
+		case Opcode::mul:
+		case Opcode::slt:
+		case Opcode::lw:
+		case Opcode::sw:
+		case Opcode::nop:
+			PCnext = PCcurr + 1;
+			break;
+		default:
+			break;
+		}
+    }
+
+    void instructionDecode1(){
+		id2.valid = id1.valid;
+		id2.command = id1.command;
+		id2.insNo = id1.insNo;
+		id2.pc = id1.pc;
+    }
+
+	void instructionDecode2(){
+		rr.valid = id2.valid;
+		rr.command = id2.command;
+		rr.insNo = id2.insNo;
+		rr.pc = id2.pc;
+
+		if (id2.valid && id2.command.op == Opcode::j){
+			PCnext = id2.command.target;
+		}
+	}
+
+	void registerReadRtype(){
+		if (!rr.valid){
+			exRtype.valid = rr.valid;
+			exRtype.command = rr.command;
+			exRtype.insNo = rr.insNo;
+			proceed = true;
+		}
+
+		else switch (rr.command.op){
+		case Opcode::add:
+		case Opcode::sub:
+		case Opcode::mul:
+		case Opcode::slt:
+			if (scoreboard.any(registerBit(rr.command.r2) | registerBit(rr.command.r3))){
+				exRtype.valid = false;
+				exRtype.insNo = -10;
+				proceed = false;
+				break;
+			}
+			exRtype.valid = rr.valid;
+			exRtype.command = rr.command;
+			scoreboard.acquire(rr.command.r1);
+			exRtype.s1_val = registers[rr.command.r2];
+			exRtype.s2_val = registers[rr.command.r3];
+			exRtype.insNo = rr.insNo;
+			proceed = true;
+			break;
+
+		case Opcode::addi:
+			if (scoreboard.any(registerBit(rr.command.r2))){
+				exRtype.valid = false;
+				exRtype.insNo = -10;
+				proceed = false;
+				break;
+			}
+			exRtype.valid = rr.valid;
+			exRtype.command = rr.command;
+			scoreboard.acquire(rr.command.r1);
+			exRtype.s1_val = registers[rr.command.r2];
+			exRtype.s2_val = rr.command.imm;
+			exRtype.insNo = rr.insNo;
+			proceed = true;
+			break;
+
+		case Opcode::end:
+			exRtype.valid = rr.valid;
+			exRtype.command = rr.command;
+			exRtype.insNo = rr.insNo;
+			proceed = true;
+			break;
+
+		case Opcode::beq:
+		case Opcode::bne:
+			if (scoreboard.any(registerBit(rr.command.r1) | registerBit(rr.command.r2))){
+				exRtype.valid = false;
+				exRtype.insNo = -10;
+				proceed = false;
+				break;
+			}
+			exRtype.valid = rr.valid;
+			exRtype.command = rr.command;
+			exRtype.s1_val = registers[rr.command.r1];
+			exRtype.s2_val = registers[rr.command.r2];
+			exRtype.insNo = rr.insNo;
+			proceed = true;
+			break;
+
+		case Opcode::j:
+		case Opcode::nop:
+			exRtype.valid = rr.valid;
+			exRtype.command = rr.command;
+			exRtype.s1_val = 0;
+			exRtype.s2_val = 0;
+			exRtype.insNo = rr.insNo;
+			proceed = true;
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	void registerReadItype(){
+		if (isIdle(rr)){
+			exItype.valid = rr.valid;
+			exItype.command = rr.command;
+			exItype.insNo = rr.insNo;
+			proceed = true;
+		}
+
+		if (rr.valid && (rr.command.op == Opcode::lw || rr.command.op == Opcode::sw)){
+			if (scoreboard.any(registerBit(rr.command.r2))){
+				exItype.valid = false;
+				exItype.insNo = -10;
+				proceed = false;
+				return;
+			}
+
+			else if (rr.command.op == Opcode::sw && scoreboard.any(registerBit(rr.command.r1))){
+				exItype.valid = false;
+				exItype.insNo = -10;
+				proceed = false;
+				return;
+			}
+
+			exItype.valid = rr.valid;
+			exItype.command = rr.command;
+			if (rr.command.op == Opcode::lw){
+				scoreboard.acquire(rr.command.r1);
+			}
+			exItype.s1_val = registers[rr.command.r1];
+			exItype.s2_val = 0;
+			exItype.insNo = rr.insNo;
+			exItype.pc = rr.pc;
+			proceed = true;
+		}
+	}
+
+	void executeRtype(){
+		// the path moves only once write back is done with its latch
+		if (!isIdle(wbRtype)) --inFlight;
+		wbRtype.valid = exRtype.valid;
+		wbRtype.command = exRtype.command;
+		wbRtype.s1_val = exRtype.s1_val;
+		wbRtype.s2_val = exRtype.s2_val;
+		wbRtype.insNo = exRtype.insNo;
+
+		if (!isIdle(exRtype)) switch (exRtype.command.op){
+		case Opcode::add:
+		case Opcode::addi:
+		case Opcode::sub:
+		case Opcode::mul:
+		case Opcode::slt:
+			wbRtype.computed_value = alu(exRtype.command.op, exRtype.s1_val, exRtype.s2_val);
+			break;
+		case Opcode::beq:
+		case Opcode::bne:
+			PCnext = taken(exRtype.command, exRtype.s1_val, exRtype.s2_val) ? exRtype.command.target : PCcurr + 1;
+			unresolvedBranch = -1;
+			break;
+		default:
+			break;
+		}
+
+		exRtype.valid = false;
+		exRtype.insNo = -10;
+	}
+
+	void executeItype(){
+		mem1.valid = exItype.valid;
+		mem1.command = exItype.command;
+		mem1.s1_val = exItype.s1_val;
+		mem1.s2_val = exItype.s2_val;
+		mem1.insNo = exItype.insNo;
+		mem1.pc = exItype.pc;
+
+		if (exItype.valid && (exItype.command.op == Opcode::lw || exItype.command.op == Opcode::sw)){
+			mem1.computed_value = locateAddress(exItype.command);
+		}
+
+		exItype.valid = false;
+		exItype.insNo = -10;
+	}
+
+	void memory1(){
+		mem2.valid = mem1.valid;
+		mem2.command = mem1.command;
+		mem2.s1_val = mem1.s1_val;
+		mem2.s2_val = mem1.s2_val;
+		mem2.computed_value = mem1.computed_value;
+		mem2.insNo = mem1.insNo;
+		mem2.pc = mem1.pc;
+	}
+
+	void memory2(){
+		if (faults(mem2)){
+			if (!isIdle(wbItype)) --inFlight;
+			wbItype.valid = false;
+			return;
+		}
+		if (mem2.valid && mem2.command.op == Opcode::sw && !outcomes){
+			data[mem2.computed_value] = mem2.s1_val;
+			dirtyPages.mark(mem2.computed_value);
+			memoryDelta[mem2.computed_value] = mem2.s1_val;
+		}
+
+		if (!isIdle(wbItype)) --inFlight;
+		wbItype.valid = mem2.valid;
+		wbItype.command = mem2.command;
+		wbItype.s1_val = mem2.s1_val;
+		wbItype.s2_val = mem2.s2_val;
+		wbItype.computed_value = mem2.computed_value;
+		wbItype.memory_value = 0;
+		wbItype.insNo = mem2.insNo;
+		if (mem2.valid && mem2.command.op == Opcode::lw && !outcomes){
+			wbItype.memory_value = data[mem2.computed_value];
+		}
+	}
+
+	// without forwarding a written register stays locked until the end of the cycle, with it readers see it at once
+	void releaseLock(int r){
+		if constexpr (FORWARDING) scoreboard.release(r);
+		else scoreboard.releaseAtEndOfCycle(r);
+	}
+
+	void writeBack(){
+		if constexpr (SplitPaths){
+			if (!wbItype.valid){
+				proceedItype = true;
+			}
+
+			else if (wbItype.command.op == Opcode::end){
+				proceedItype = true;
+				endItype = true;
+			}
+
+			else if (wbItype.command.op == Opcode::sw){
+				proceedItype = true;
+			}
+
+			if (!wbRtype.valid){
+				proceedRtype = true;
+			}
+
+			else if (wbRtype.command.op == Opcode::end){
+				proceedRtype = true;
+				endRtype = true;
+			}
+
+			if (wbRtype.valid && (wbRtype.command.op == Opcode::j || wbRtype.command.op == Opcode::beq || wbRtype.command.op == Opcode::bne || wbRtype.command.op == Opcode::nop)){
+				proceedRtype = true;
+			}
+
+			// one register write per cycle, in fetch order
+			else if (!isIdle(wbRtype) && wbRtype.insNo == lastWrite + 1){
+				proceedRtype = true;
+				registers[wbRtype.command.r1] = wbRtype.computed_value;
+				releaseLock(wbRtype.command.r1);
+				lastWrite ++;
+				return;
+			}
+
+			else if (!isIdle(wbItype) && wbItype.insNo == lastWrite + 1){
+				proceedItype = true;
+				if (wbItype.command.op == Opcode::lw){
+					releaseLock(wbItype.command.r1);
+				}
+				registers[wbItype.command.r1] = wbItype.memory_value;
+				lastWrite ++;
+				return;
+			}
+		}
+		else{
+			const WB &wb = now().wb;
+			const Opcode op = wb.command.op;
+			if (!isIdle(wb)) --inFlight;
+			if (wb.valid) switch (op){
+			case Opcode::add:
+			case Opcode::sub:
+			case Opcode::mul:
+			case Opcode::slt:
+			case Opcode::addi:
+				registers[wb.command.r1] = wb.computed_value;
+				// with forwarding the value was handed on before write back, no lock waits for it
+				if constexpr (!FORWARDING) scoreboard.release(wb.command.r1);
+				break;
+			case Opcode::lw:
+				registers[wb.command.r1] = wb.memory_value;
+				if constexpr (!FORWARDING) scoreboard.release(wb.command.r1);
+				break;
+			case Opcode::end:
+				endPipeline = true;
+				break;
+			default:
+				break;
+			}
+		}
+	}
+
+
+	/*
+		one clock cycle of the 5 stage pipeline in a single sweep from the back: write back and the
+		store go first, as in the first half of the cycle, so the stages after them read the registers
+		and memory as of the second half. A stalled stage puts a bubble in its next latch and the
+		stages before it keep their instructions.
+	*/
+	void cycleFiveStage(){
+		writeBack();
+		memory();
+		// only with forwarding can memory and execute stall
+		if (!FORWARDING || proceed) execute();
+		else next().mem = now().mem;
+		if (!FORWARDING || proceed) instructionDecode();
+		else next().ex = now().ex;
+		if (proceed) instructionFetch();
+		else next().id = now().id;
+
+		proceed = true;
+		current ^= 1;
+	}
+
+	// one clock cycle of the split pipeline, a path moves only if its write back did
+	void cycleSplit(){
+		proceedItype = false;
+		proceedRtype = false;
+		proceed = false;
+
+		writeBack();
+
+		if (proceedRtype){
+			executeRtype();
+			registerReadRtype();
+		}
+
+		if (proceedItype){
+			memory2();
+			memory1();
+			executeItype();
+			registerReadItype();
+		}
+
+		if (proceed){
+			instructionDecode2();
+			instructionDecode1();
+			instructionFetch2();
+			instructionFetch1();
+		}
+	}
+
+	// one clock cycle of the model, the locks written back in it released at its end
+	void cycle()
+	{
+		if constexpr (SplitPaths)
+			cycleSplit();
+		else
+			cycleFiveStage();
+		scoreboard.endCycle();
+	}
+
+	// the instruction the last fetch put in the pipeline
+	Instruction &fetched()
+	{
+		if constexpr (SplitPaths)
+			return if2.command;
+		else
+			return now().id.command;
+	}
+
+	/*
+		all a timing only run goes on, the values aside: saved at the start of a basic block and
+		restored to replay the block's timing (TimingMemo.hpp)
+	*/
+	struct TimingState
+	{
+		int PCcurr, PCnext, noOfStalls, inFlight, unresolvedBranch, insNo, lastWrite, current;
+		bool proceed, branchStall, endPipeline, proceedRtype, proceedItype, endRtype, endItype;
+		Scoreboard scoreboard;
+		FiveStageLatches fiveStage[2];
+		IF if2;
+		ID id1, id2;
+		RR rr;
+		EX exItype, exRtype;
+		MEM mem1, mem2;
+		WB wbItype, wbRtype;
+	};
+
+	// the engine and TimingState name their fields alike
+	template <typename From, typename To>
+	static void copyTiming(const From &from, To &to)
+	{
+		to.PCcurr = from.PCcurr, to.PCnext = from.PCnext, to.noOfStalls = from.noOfStalls, to.inFlight = from.inFlight;
+		to.unresolvedBranch = from.unresolvedBranch, to.insNo = from.insNo, to.lastWrite = from.lastWrite;
+		to.proceed = from.proceed, to.branchStall = from.branchStall, to.endPipeline = from.endPipeline;
+		to.proceedRtype = from.proceedRtype, to.proceedItype = from.proceedItype, to.endRtype = from.endRtype, to.endItype = from.endItype;
+		to.scoreboard = from.scoreboard;
+		if constexpr (SplitPaths){
+			to.if2 = from.if2, to.id1 = from.id1, to.id2 = from.id2, to.rr = from.rr;
+			to.exItype = from.exItype, to.exRtype = from.exRtype, to.mem1 = from.mem1, to.mem2 = from.mem2;
+			to.wbItype = from.wbItype, to.wbRtype = from.wbRtype;
+		}
+		else{
+			to.fiveStage[0] = from.fiveStage[0], to.fiveStage[1] = from.fiveStage[1];
+			to.current = from.current;
+		}
+	}
+
+	void saveTiming(TimingState &state) const { copyTiming(*this, state); }
+	void restoreTiming(const TimingState &state) { copyTiming(state, *this); }
+
+	/*
+		the timing state as a key of equal timing: latch values and the contents of empty latches are
+		left out, and the write back order numbers are taken relative to the last write
+	*/
+	void timingSignature(std::string &key) const
+	{
+		auto put = [&key](auto v){ key.append((const char *)&v, sizeof(v)); };
+		auto latch = [&](const auto &l){
+			put(l.valid);
+			if (l.valid){
+				put(l.command);
+				put(l.insNo == -10 ? INT_MIN : l.insNo - lastWrite);
+			}
+		};
+		put(PCcurr), put(PCnext), put(noOfStalls), put(inFlight), put(unresolvedBranch), put(insNo - lastWrite);
+		put(proceed), put(branchStall), put(endPipeline), put(proceedRtype), put(proceedItype), put(endRtype), put(endItype);
+		put(scoreboard.busy), put(scoreboard.releasing);
+		for (uint32_t b = scoreboard.busy; b; b &= b - 1)
+			put(scoreboard.pending[__builtin_ctz(b)]);
+		if constexpr (SplitPaths){
+			latch(if2), latch(id1), latch(id2), latch(rr), latch(exItype), latch(exRtype);
+			latch(mem1), latch(mem2), latch(wbItype), latch(wbRtype);
+		}
+		else{
+			latch(now().id), latch(now().ex), latch(now().mem), latch(now().wb);
+		}
+	}
+
+	bool pipelineEnded() const
+	{
+		if constexpr (SplitPaths)
+			return endRtype && endItype;
+		else
+			return endPipeline;
+	}
+
+	bool pipelineIdle() const
+	{
+		return inFlight == 0;
+	}
+
+	// run the program through the pipeline, returns the cycles it took
+	long long executeCommandsPipelined()
+	{
+		if (reportLoadFailure())
+			return 0;
+
+		int clockCycles = 0;
+
+		printRegisters();
+		memcpy(printed, registers, sizeof(printed));
+#ifdef MIPS_COUNT_ALLOCS
+		const unsigned long long steadyAllocations = allocationCount();
+#endif
+		while (!pipelineEnded())
+		{
+			clockCycles++;
+			if (fetchBudget > 0 && fetchBudget <= measured)
+				++measuredCycles;
+
+			cycle();
+			occupancy.record(inFlight);
+
+			traceCycle();
+			if (faultAt >= 0)
+			{
+				flushIdleCycles();
+				PCcurr = faultAt;
+				handleExit(INVALID_ADDRESS, clockCycles, false);
+				return clockCycles;
+			}
+#ifdef MIPS_COUNT_ALLOCS
+			assert(allocationCount() == steadyAllocations && "pipeline cycle allocated on the heap");
+#endif
+
+			if (pipelineIdle()) break;
+		}
+		flushIdleCycles();
+		return clockCycles;
+	}
+
+	// print the cycle, or count it as idle in the event driven output
+	void traceCycle()
+	{
+		if (!skipIdle)
+		{
+			printRegisters();
+			return;
+		}
+		if (memoryDelta.size() == 0 && memcmp(registers, printed, sizeof(printed)) == 0)
+		{
+			if (++idleCycles == IDLE_FLUSH)
+				flushIdleCycles();
+			return;
+		}
+		flushIdleCycles();
+		printRegisters();
+		memcpy(printed, registers, sizeof(printed));
+	}
+
+	// the idle cycles since the last change, formatted once when they are expanded
+	void flushIdleCycles()
+	{
+		if (idleCycles == 0)
+			return;
+		if (expandIdle)
+		{
+			char line[32 * 12 + 8];
+			int n = 0;
+			for (int i = 0; i < 32; ++i)
+				n += snprintf(line + n, sizeof(line) - n, "%d ", printed[i]);
+			n += snprintf(line + n, sizeof(line) - n, "\n0 \n");
+			for (; idleCycles > 0; --idleCycles)
+				out->write(line, n);
+		}
+		else
+			*out << "(" << idleCycles << " idle cycles)\n";
+		idleCycles = 0;
+	}
+
+	/*
+		execute the commands sequentially at full speed: only the registers at the end and the exit
+		report are printed, and the instructions are counted only when profiling
+	*/
+	void executeCommandsFunctional(bool profile = false)
+	{
+		if (reportLoadFailure())
+			return;
+
+		long long steps = 0;
+		exit_code code = profile ? runThreaded<true>(*this, threaded, steps) : runThreaded<false>(*this, threaded, steps);
+		printRegisters();
+		handleExit(code, steps, profile);
+	}
+
+	/*
+		run the first n instructions functionally, leaving the registers, data and PC they produce for
+		executeCommandsPipelined to carry on from; an lw/sw that would fault is left to the pipeline,
+		which reports it. Returns the number of instructions run
+	*/
+	long long fastForward(long long n)
+	{
+		if (n <= 0 || program->commands.size() >= MAX / 4 || program->loadError != SUCCESS)
+			return 0;
+		long long steps = 0;
+		if (runJit<true>(*this, jit, bounded, steps, n) == INVALID_ADDRESS)
+			--steps;
+		memcpy(latch_reg, registers, sizeof(latch_reg));
+		return steps;
+	}
+
+	// as executeCommandsFunctional without profiling, running hot blocks as translated host code
+	void executeCommandsJit()
+	{
+		if (reportLoadFailure())
+			return;
+
+		long long steps = 0;
+		exit_code code = runJit(*this, jit, threaded, steps);
+		printRegisters();
+		handleExit(code, steps, false);
+	}
+
+	// execute the commands sequentially (no pipelining)
+	void executeCommandsUnpipelined()
+	{
+		if (reportLoadFailure())
+			return;
+
+		int clockCycles = 0;
+		while (PCcurr < program->instructions.size())
+		{
+			++clockCycles;
+			const Instruction &ins = program->instructions[PCcurr];
+			PCnext = PCcurr + 1;
+			switch (ins.op)
+			{
+			case Opcode::add:
+				registers[ins.r1] = registers[ins.r2] + registers[ins.r3];
+				break;
+			case Opcode::sub:
+				registers[ins.r1] = registers[ins.r2] - registers[ins.r3];
+				break;
+			case Opcode::mul:
+				registers[ins.r1] = registers[ins.r2] * registers[ins.r3];
+				break;
+			case Opcode::slt:
+				registers[ins.r1] = registers[ins.r2] < registers[ins.r3];
+				break;
+			case Opcode::addi:
+				registers[ins.r1] = registers[ins.r2] + ins.imm;
+				break;
+			case Opcode::beq:
+				if (registers[ins.r1] == registers[ins.r2])
+					PCnext = ins.target;
+				break;
+			case Opcode::bne:
+				if (registers[ins.r1] != registers[ins.r2])
+					PCnext = ins.target;
+				break;
+			case Opcode::j:
+				PCnext = ins.target;
+				break;
+			case Opcode::lw:
+			case Opcode::sw:
+			{
+				int address = locateAddress(ins);
+				if (address < 0)
+				{
+					handleExit(INVALID_ADDRESS, clockCycles);
+					return;
+				}
+				if (ins.op == Opcode::lw)
+					registers[ins.r1] = data[address];
+				else
+				{
+					data[address] = registers[ins.r1];
+					dirtyPages.mark(address);
+				}
+				break;
+			}
+			default:
+				break;
+			}
+			++commandCount[PCcurr];
+			PCcurr = PCnext;
+			printRegisters();
+		}
+		handleExit(SUCCESS, clockCycles);
+	}
+
+
+
+	// cycles spent with each number of instructions in flight
+	void printOccupancy()
+	{
+		*err << "Average pipeline occupancy: " << occupancy.average() << " of " << LATCHES << " latches over " << occupancy.total() << " cycles\n";
+		for (int k = 0; k <= LATCHES; ++k)
+			*err << k << " in flight: " << occupancy.cycles[k] << " cycles\n";
+	}
+
+	// print the register data in hexadecimal
+	void printRegisters()
+	{
+		for (int i = 0; i < 32; ++i)
+			*out << registers[i] << ' ';
+		*out << '\n';
+		*out << memoryDelta.size() << ' ';
+		if(memoryDelta.size()==0){
+			*out<<'\n';
+		}
+		for (auto &p : memoryDelta)
+		*out << p.first << ' ' << p.second << '\n';
+		memoryDelta.clear();
+	}
+};
+
+#endif
@@ -0,0 +1,219 @@
+/**
+ * @file Program.hpp
+ * @brief A loaded program: the source, its commands and the decoded and verified instructions
+ *
+ * All the parsing and checking is done while loading; afterwards the program is only read, so one
+ * instance can be shared by any number of simulators, on any threads.
+ */
+
+#ifndef __PROGRAM_HPP__
+#define __PROGRAM_HPP__
+
+#include <algorithm>
+#include <list>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "Parser.hpp"
+#include "ProgramImage.hpp"
+#include "MachineCode.hpp"
+
+enum exit_code
+{
+	SUCCESS = 0,
+	INVALID_REGISTER,
+	INVALID_LABEL,
+	INVALID_ADDRESS,
+	SYNTAX_ERROR,
+	MEMORY_ERROR
+};
+
+struct Program
+{
+	SourceText source; // commands and labels are views into it
+	std::unordered_map<std::string_view, int> address;
+	std::vector<Command> commands;
+	std::list<std::string> joinedOperands;
+	std::vector<int> commandLines;
+	std::vector<Instruction> instructions;
+
+	// first error found by verifyProgram, reported before anything runs
+	exit_code loadError = SUCCESS;
+	int loadErrorAt = 0;
+	// all of them in program order, each with the index of its command
+	std::vector<std::pair<int, exit_code>> loadErrors;
+
+	// index of the first instruction to run, machine code may start anywhere
+	int entry = 0;
+
+	// parse, decode and verify the source, or take it from machine code or the cached image
+	explicit Program(SourceText &&text) : source(std::move(text))
+	{
+		if (!loadMachineProgram() && !loadCachedImage())
+		{
+			constructCommands();
+			decodeCommands();
+			verifyProgram();
+			saveCachedImage();
+		}
+	}
+
+	// the views would dangle in a copy
+	Program(const Program &) = delete;
+	Program &operator=(const Program &) = delete;
+
+	// checks if label is valid
+	static bool checkLabel(std::string_view str)
+	{
+		return str.size() > 0 && isalpha(str[0]) && std::all_of(str.begin() + 1, str.end(), [](char c)
+														   { return (bool)isalnum(c); }) &&
+			   opcodeOf(str) == Opcode::invalid;
+	}
+
+	// checks if the register is a valid one
+	static bool checkRegister(std::string_view r)
+	{
+		return registerIndex(r) >= 0;
+	}
+
+	// checks if all of the registers are valid or not
+	static bool checkRegisters(std::initializer_list<std::string_view> regs)
+	{
+		return std::all_of(regs.begin(), regs.end(), [&](std::string_view r)
+						   { return checkRegister(r); });
+	}
+
+	// construct the commands vector from the source text, scanned in place and in parallel for large sources
+	void constructCommands()
+	{
+		parseSource(source.text(), commands, commandLines, address, joinedOperands);
+	}
+
+	// decode the program from machine code when the source is an ELF or raw .bin image rather than assembly
+	bool loadMachineProgram()
+	{
+		MachineFormat format = machineFormat(source.fileName, source.text());
+		if (format == MachineFormat::none)
+			return false;
+		switch (loadMachineCode(source.text(), format, instructions, commands, commandLines, joinedOperands, entry, loadErrorAt))
+		{
+		case MachineError::malformed:
+		case MachineError::unsupported:
+			loadError = SYNTAX_ERROR;
+			break;
+		case MachineError::badTarget:
+			loadError = INVALID_LABEL;
+			break;
+		default:
+			break;
+		}
+		if (loadError != SUCCESS)
+			loadErrors.emplace_back(loadErrorAt, loadError);
+		return true;
+	}
+
+	// take the decoded and verified program from the image cached for this source, only mapped files that load without errors are cached
+	bool loadCachedImage()
+	{
+		int error = SUCCESS;
+		if (!source.mapped || !loadImage(imagePath(source.fileName), source.text(), instructions, commands, commandLines, joinedOperands, error, loadErrorAt))
+			return false;
+		loadError = (exit_code)error;
+		return true;
+	}
+
+	void saveCachedImage()
+	{
+		if (source.mapped && loadError == SUCCESS)
+			saveImage(imagePath(source.fileName), source.text(), instructions, commands, commandLines, loadError, loadErrorAt);
+	}
+
+	// decode every command once, after all the labels are known
+	void decodeCommands()
+	{
+		instructions.resize(commands.size());
+		parallelFor(commands.size(), workerThreads(commands.size(), DECODE_COMMANDS_PER_THREAD), [&](size_t begin, size_t end)
+					{
+			for (size_t i = begin; i < end; ++i)
+				instructions[i] = decodeInstruction(commands[i], address); });
+	}
+
+	// check every command once so that the executors run without per instruction checks
+	void verifyProgram()
+	{
+		// every range collects its errors, merged in program order
+		std::mutex merge;
+		parallelFor(instructions.size(), workerThreads(instructions.size(), DECODE_COMMANDS_PER_THREAD), [&](size_t begin, size_t end)
+					{
+			std::vector<std::pair<int, exit_code>> found;
+			for (size_t i = begin; i < end; ++i)
+				if (exit_code code = verifyCommand(commands[i], instructions[i]); code != SUCCESS)
+					found.emplace_back(i, code);
+			std::lock_guard<std::mutex> lock(merge);
+			loadErrors.insert(loadErrors.end(), found.begin(), found.end()); });
+		std::sort(loadErrors.begin(), loadErrors.end());
+		if (!loadErrors.empty())
+		{
+			loadErrorAt = loadErrors[0].first;
+			loadError = loadErrors[0].second;
+		}
+	}
+
+	// the error the command would have raised when executed, SUCCESS if none
+	static exit_code verifyCommand(const Command &command, const Instruction &ins)
+	{
+		switch (ins.op)
+		{
+		case Opcode::add:
+		case Opcode::sub:
+		case Opcode::mul:
+		case Opcode::slt:
+			return checkRegisters({command[1], command[2], command[3]}) && ins.r1 != 0 ? SUCCESS : INVALID_REGISTER;
+		case Opcode::addi:
+		{
+			int imm;
+			if (!checkRegisters({command[1], command[2]}) || ins.r1 == 0)
+				return INVALID_REGISTER;
+			return parseInt(command[3], imm) ? SUCCESS : SYNTAX_ERROR;
+		}
+		case Opcode::beq:
+		case Opcode::bne:
+			if (!checkLabel(command[3]))
+				return SYNTAX_ERROR;
+			if (ins.target == -1)
+				return INVALID_LABEL;
+			return checkRegisters({command[1], command[2]}) ? SUCCESS : INVALID_REGISTER;
+		case Opcode::j:
+			if (!checkLabel(command[1]))
+				return SYNTAX_ERROR;
+			return ins.target == -1 ? INVALID_LABEL : SUCCESS;
+		case Opcode::lw:
+		case Opcode::sw:
+			if (!checkRegister(command[1]) || (ins.op == Opcode::lw && ins.r1 == 0))
+				return INVALID_REGISTER;
+			return checkAddress(command[2]);
+		default:
+			return SYNTAX_ERROR;
+		}
+	}
+
+	// syntax of an lw/sw operand, the address itself is only known at run time
+	static exit_code checkAddress(std::string_view location)
+	{
+		int offset;
+		if (!location.empty() && location.back() == ')')
+		{
+			size_t lparen = location.find('(');
+			if (!parseInt(lparen == 0 ? "0" : location.substr(0, lparen), offset))
+				return SYNTAX_ERROR;
+			std::string_view reg = location.substr(lparen + 1);
+			reg.remove_suffix(1);
+			return checkRegister(reg) ? SUCCESS : INVALID_ADDRESS;
+		}
+		return parseInt(location, offset) ? SUCCESS : SYNTAX_ERROR;
+	}
+};
+
+#endif
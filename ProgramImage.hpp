@@ -0,0 +1,209 @@
+/**
+ * @file ProgramImage.hpp
+ * @brief Cached decoded program (<source>.mipsbin), keyed by a hash of the source text
+ *
+ * The first load of a source writes the parsed, decoded and verified program next to it; later
+ * loads of the same text, by any of the models, map the image instead of parsing again.
+ */
+
+#ifndef __PROGRAM_IMAGE_HPP__
+#define __PROGRAM_IMAGE_HPP__
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <list>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <sys/stat.h>
+#include "Instruction.hpp"
+
+static const char IMAGE_MAGIC[8] = {'M', 'I', 'P', 'S', 'B', 'I', 'N', '\0'};
+// bump whenever decoding or verifying changes what a source loads to, the source hash does not cover that
+static const uint32_t IMAGE_VERSION = 2;
+
+// layout: header, Instruction[commands], int32 line[commands], TokenRef[commands][4], joined operand text
+struct ImageHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t instructionSize;
+	uint64_t sourceHash;
+	uint64_t sourceSize;
+	uint64_t commands;
+	uint64_t joinedSize;
+	int32_t loadError;
+	int32_t loadErrorAt;
+};
+
+// a token is a slice of the source, or of the joined operand text when the top bit of offset is set
+struct TokenRef
+{
+	uint32_t offset;
+	uint32_t length;
+};
+
+static const uint32_t JOINED_TOKEN = 1u << 31;
+
+// 64 bit hash of the source, four independent lanes over 8 byte words so it runs near memory speed
+inline uint64_t contentHash(std::string_view text)
+{
+	const uint64_t prime = 0x9E3779B97F4A7C15ull;
+	uint64_t lane[4] = {prime, prime ^ 1, prime ^ 2, prime ^ 3};
+	auto mix = [&](uint64_t h, uint64_t word)
+	{
+		h = (h ^ word) * prime;
+		return h ^ (h >> 29);
+	};
+	const char *p = text.data();
+	size_t n = text.size(), i = 0;
+	for (; i + 32 <= n; i += 32)
+		for (int k = 0; k < 4; ++k)
+		{
+			uint64_t word;
+			memcpy(&word, p + i + 8 * k, 8);
+			lane[k] = mix(lane[k], word);
+		}
+	for (int k = 0; i < n; i += 8, ++k)
+	{
+		uint64_t word = 0;
+		memcpy(&word, p + i, std::min<size_t>(8, n - i));
+		lane[k & 3] = mix(lane[k & 3], word);
+	}
+	uint64_t h = n;
+	for (int k = 0; k < 4; ++k)
+		h = mix(h, lane[k]);
+	return h;
+}
+
+inline std::string imagePath(const std::string &sourcePath)
+{
+	return sourcePath + ".mipsbin";
+}
+
+/*
+	fill the program from the image of this source, false if there is none, it was built from a
+	different text (or by a build with a different Instruction layout) or its instructions are out of
+	range, nothing is modified then
+*/
+inline bool loadImage(const std::string &path, std::string_view text, std::vector<Instruction> &program, std::vector<Command> &commands, std::vector<int> &commandLines, std::list<std::string> &joinedOperands, int &loadError, int &loadErrorAt)
+{
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+	struct stat st;
+	void *image = MAP_FAILED;
+	if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(ImageHeader))
+		image = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (image == MAP_FAILED)
+		return false;
+
+	const ImageHeader &header = *static_cast<const ImageHeader *>(image);
+	const char *body = static_cast<const char *>(image) + sizeof(ImageHeader);
+	const size_t bodySize = st.st_size - sizeof(ImageHeader);
+	const size_t record = sizeof(Instruction) + sizeof(int32_t) + 4 * sizeof(TokenRef);
+	const size_t n = header.commands;
+	// n is bounded by the file before it is multiplied
+	bool valid = memcmp(header.magic, IMAGE_MAGIC, sizeof(IMAGE_MAGIC)) == 0 && header.version == IMAGE_VERSION && header.instructionSize == sizeof(Instruction) &&
+				 header.sourceSize == text.size() && n <= bodySize / record && header.joinedSize == bodySize - n * record &&
+				 header.sourceHash == contentHash(text) && header.loadError == 0 && header.loadErrorAt >= 0 && (uint64_t)header.loadErrorAt <= n;
+	const Instruction *instructions = reinterpret_cast<const Instruction *>(body);
+	const int32_t *lines = reinterpret_cast<const int32_t *>(instructions + n);
+	const TokenRef *tokens = reinterpret_cast<const TokenRef *>(lines + n);
+	// a corrupted image must not reach the pipelines, which index registers and jump without checks, nor slice past the texts
+	for (size_t i = 0; valid && i < n; ++i)
+	{
+		const Instruction &ins = instructions[i];
+		valid = ins.op <= Opcode::invalid && ins.r1 < 32 && ins.r2 < 32 && ins.r3 < 32 && ins.target >= 0 && (size_t)ins.target <= n;
+		for (int k = 0; valid && k < 4; ++k)
+		{
+			const TokenRef &t = tokens[4 * i + k];
+			const uint64_t end = (uint64_t)(t.offset & ~JOINED_TOKEN) + t.length;
+			valid = end <= (t.offset & JOINED_TOKEN ? header.joinedSize : text.size());
+		}
+	}
+	if (valid)
+	{
+		joinedOperands.emplace_back(reinterpret_cast<const char *>(tokens + 4 * n), header.joinedSize);
+		std::string_view joined = joinedOperands.back();
+
+		program.assign(instructions, instructions + n);
+		commandLines.assign(lines, lines + n);
+		commands.resize(n);
+		for (size_t i = 0; i < n; ++i)
+			for (int k = 0; k < 4; ++k)
+			{
+				const TokenRef &t = tokens[4 * i + k];
+				commands[i][k] = t.offset & JOINED_TOKEN ? joined.substr(t.offset & ~JOINED_TOKEN, t.length) : text.substr(t.offset, t.length);
+			}
+		loadError = header.loadError;
+		loadErrorAt = header.loadErrorAt;
+	}
+	munmap(image, st.st_size);
+	return valid;
+}
+
+// write the image through a temporary file so concurrent runs never see a partial one, failures are ignored
+inline void saveImage(const std::string &path, std::string_view text, const std::vector<Instruction> &program, const std::vector<Command> &commands, const std::vector<int> &commandLines, int loadError, int loadErrorAt)
+{
+	if (text.size() >= JOINED_TOKEN)
+		return;
+	size_t n = program.size();
+	std::vector<TokenRef> tokens(4 * n);
+	std::string joined;
+	for (size_t i = 0; i < n; ++i)
+		for (int k = 0; k < 4; ++k)
+		{
+			std::string_view token = commands[i][k];
+			TokenRef &t = tokens[4 * i + k];
+			t.length = token.size();
+			if (token.empty())
+				t.offset = 0;
+			else if (token.data() >= text.data() && token.data() + token.size() <= text.data() + text.size())
+				t.offset = token.data() - text.data();
+			else
+			{
+				t.offset = JOINED_TOKEN | joined.size();
+				joined.append(token);
+			}
+		}
+
+	ImageHeader header = {};
+	memcpy(header.magic, IMAGE_MAGIC, sizeof(IMAGE_MAGIC));
+	header.version = IMAGE_VERSION;
+	header.instructionSize = sizeof(Instruction);
+	header.sourceHash = contentHash(text);
+	header.sourceSize = text.size();
+	header.commands = n;
+	header.joinedSize = joined.size();
+	header.loadError = loadError;
+	header.loadErrorAt = loadErrorAt;
+	std::vector<int32_t> lines(commandLines.begin(), commandLines.end());
+
+	// unique per writer, threads of one process included
+	std::string temporary = path + ".XXXXXX";
+	int fd = mkstemp(&temporary[0]);
+	if (fd < 0)
+		return;
+	fchmod(fd, 0644);
+	FILE *out = fdopen(fd, "wb");
+	if (!out)
+	{
+		::close(fd);
+		remove(temporary.c_str());
+		return;
+	}
+	bool ok = fwrite(&header, sizeof(header), 1, out) == 1 &&
+			  fwrite(program.data(), sizeof(Instruction), n, out) == n &&
+			  fwrite(lines.data(), sizeof(int32_t), n, out) == n &&
+			  fwrite(tokens.data(), sizeof(TokenRef), 4 * n, out) == 4 * n &&
+			  fwrite(joined.data(), 1, joined.size(), out) == joined.size();
+	ok = fclose(out) == 0 && ok;
+	if (!ok || rename(temporary.c_str(), path.c_str()) != 0)
+		remove(temporary.c_str());
+}
+
+#endif
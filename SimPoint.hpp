@@ -0,0 +1,280 @@
+/**
+ * @file SimPoint.hpp
+ * @brief SimPoint style sampling: the program runs functionally once, split into intervals of a fixed
+ * number of instructions, each described by its basic block vector; the vectors are clustered and
+ * only one representative interval per cluster is simulated in detail
+ *
+ * A basic block vector counts the instructions run in every block during the interval. The vectors
+ * are normalized and reduced by a random projection to PROJECTED_DIMENSIONS before k-means, for every
+ * number of clusters up to the maximum; the smallest clustering scoring within 90% of the best BIC is
+ * kept. Each cluster's interval nearest to its centroid represents it, weighted by the instructions
+ * of the cluster. The cycles of a pipelined model are estimated from the cycles per instruction of
+ * the representatives, simulated after fast-forwarding to them, as the weighted sum times the
+ * instructions of the whole run.
+ */
+
+#ifndef __SIM_POINT_HPP__
+#define __SIM_POINT_HPP__
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <ostream>
+#include <random>
+#include <vector>
+#include "Program.hpp"
+#include "ThreadedCode.hpp"
+
+struct SimPoints
+{
+	static const int PROJECTED_DIMENSIONS = 15;
+	static const int KMEANS_ITERATIONS = 100;
+
+	struct Point
+	{
+		long long interval; // index, it starts at interval * intervalSize instructions
+		double weight;		// fraction of all the instructions run in its cluster
+	};
+
+	long long intervalSize = 0;
+	long long instructions = 0;		// run functionally in all
+	std::vector<long long> lengths; // instructions of each interval, only the last may be shorter
+	std::vector<int> cluster;		// of each interval
+	std::vector<Point> points;
+};
+
+namespace simpoint
+{
+	typedef std::vector<double> Vector;
+
+	inline double distance2(const Vector &a, const Vector &b)
+	{
+		double d = 0;
+		for (size_t i = 0; i < a.size(); ++i)
+			d += (a[i] - b[i]) * (a[i] - b[i]);
+		return d;
+	}
+
+	// Lloyd's k-means from a k-means++ seeding, returns the sum of squared distances to the centroids
+	inline double kmeans(const std::vector<Vector> &x, int k, std::mt19937 &random, std::vector<int> &assigned, std::vector<Vector> &centroids)
+	{
+		const size_t n = x.size();
+		centroids.assign(1, x[random() % n]);
+		std::vector<double> nearest(n);
+		while ((int)centroids.size() < k)
+		{
+			double total = 0;
+			for (size_t i = 0; i < n; ++i)
+			{
+				nearest[i] = std::numeric_limits<double>::max();
+				for (const Vector &c : centroids)
+					nearest[i] = std::min(nearest[i], distance2(x[i], c));
+				total += nearest[i];
+			}
+			size_t pick = 0;
+			if (total > 0)
+			{
+				double r = std::uniform_real_distribution<double>(0, total)(random);
+				while (pick + 1 < n && (r -= nearest[pick]) > 0)
+					++pick;
+			}
+			else
+				pick = random() % n;
+			centroids.push_back(x[pick]);
+		}
+
+		assigned.assign(n, -1);
+		double sse = 0;
+		for (int iteration = 0; iteration < SimPoints::KMEANS_ITERATIONS; ++iteration)
+		{
+			bool moved = false;
+			sse = 0;
+			for (size_t i = 0; i < n; ++i)
+			{
+				int best = 0;
+				double bestDistance = distance2(x[i], centroids[0]);
+				for (int c = 1; c < k; ++c)
+				{
+					double d = distance2(x[i], centroids[c]);
+					if (d < bestDistance)
+						best = c, bestDistance = d;
+				}
+				moved |= assigned[i] != best;
+				assigned[i] = best;
+				sse += bestDistance;
+			}
+			if (!moved)
+				break;
+			std::vector<int> size(k, 0);
+			for (Vector &c : centroids)
+				std::fill(c.begin(), c.end(), 0);
+			for (size_t i = 0; i < n; ++i)
+			{
+				++size[assigned[i]];
+				for (size_t d = 0; d < x[i].size(); ++d)
+					centroids[assigned[i]][d] += x[i][d];
+			}
+			for (int c = 0; c < k; ++c)
+				for (double &v : centroids[c])
+					v = size[c] ? v / size[c] : 0;
+		}
+		return sse;
+	}
+
+	// Bayesian information criterion of a clustering under spherical Gaussians, as X-means scores it
+	inline double bic(size_t n, int k, int dimensions, double sse, const std::vector<int> &assigned)
+	{
+		const double variance = std::max(sse / std::max<double>(n - k, 1), 1e-12);
+		std::vector<double> size(k, 0);
+		for (int c : assigned)
+			++size[c];
+		double likelihood = 0;
+		for (double r : size)
+			if (r > 0)
+				likelihood += r * std::log(r) - r * std::log((double)n) - r / 2 * std::log(2 * M_PI) - r * dimensions / 2 * std::log(variance) - (r - k) / 2;
+		return likelihood - k * (dimensions + 1) / 2.0 * std::log((double)n);
+	}
+}
+
+/*
+	run the program functionally on m, from a fresh reset, collecting a basic block vector every
+	intervalSize instructions, then choose up to maxClusters representative intervals
+*/
+template <typename Simulator>
+SimPoints selectSimPoints(Simulator &m, std::shared_ptr<const Program> program, long long intervalSize, int maxClusters)
+{
+	SimPoints result;
+	result.intervalSize = intervalSize;
+	m.reset(program);
+	const std::vector<Instruction> &instructions = program->instructions;
+	const int n = instructions.size();
+	if (n >= m.MAX / 4 || program->loadError != SUCCESS || intervalSize <= 0)
+		return result;
+
+	// blocks start at the entry, at branch targets and after branches, and run to the next start
+	std::vector<char> leader(n + 1, 0);
+	leader[program->entry] = leader[n] = 1;
+	for (int i = 0; i < n; ++i)
+		if (isBranch(instructions[i].op))
+			leader[instructions[i].target] = leader[i + 1] = 1;
+	std::vector<int> starts, blockLength;
+	for (int i = 0; i < n; ++i)
+		if (leader[i])
+			starts.push_back(i);
+	for (size_t b = 0; b < starts.size(); ++b)
+		blockLength.push_back((b + 1 < starts.size() ? starts[b + 1] : n) - starts[b]);
+
+	/*
+		each block entry counts the whole block, a block cut by the interval boundary is credited to the
+		interval entering it; the threaded code is translated in the first interval and reused by the
+		others, and only the counts of the blocks that ran are cleared after each
+	*/
+	std::vector<std::vector<std::pair<int, long long>>> vectors;
+	for (;;)
+	{
+		long long steps = 0;
+		exit_code code = runThreaded<true, false, true>(m, m.threaded, steps, intervalSize);
+		if (steps == 0)
+			break;
+		std::vector<std::pair<int, long long>> bbv;
+		for (size_t b = 0; b < starts.size(); ++b)
+			if (int entered = m.commandCount[starts[b]])
+			{
+				bbv.emplace_back(b, (long long)entered * blockLength[b]);
+				std::fill_n(m.commandCount.begin() + starts[b], blockLength[b], 0);
+			}
+		vectors.push_back(std::move(bbv));
+		result.lengths.push_back(steps);
+		result.instructions += steps;
+		if (code != SUCCESS || m.PCcurr >= n)
+			break;
+	}
+	const size_t intervals = vectors.size();
+	if (intervals == 0)
+		return result;
+
+	// normalized vectors through one random projection, the same for every interval
+	const int D = SimPoints::PROJECTED_DIMENSIONS;
+	std::mt19937 random(1);
+	std::uniform_real_distribution<double> uniform(-1, 1);
+	std::vector<double> projection(starts.size() * D);
+	for (double &p : projection)
+		p = uniform(random);
+	std::vector<simpoint::Vector> x(intervals, simpoint::Vector(D, 0));
+	for (size_t i = 0; i < intervals; ++i)
+	{
+		double total = 0;
+		for (auto &e : vectors[i])
+			total += e.second;
+		for (auto &e : vectors[i])
+			for (int d = 0; d < D; ++d)
+				x[i][d] += e.second / total * projection[e.first * D + d];
+	}
+
+	std::vector<std::vector<int>> assignments;
+	std::vector<std::vector<simpoint::Vector>> centroids;
+	std::vector<double> scores;
+	const int most = std::min<long long>(maxClusters, intervals);
+	for (int k = 1; k <= most; ++k)
+	{
+		assignments.emplace_back();
+		centroids.emplace_back();
+		double sse = simpoint::kmeans(x, k, random, assignments.back(), centroids.back());
+		scores.push_back(simpoint::bic(intervals, k, D, sse, assignments.back()));
+	}
+	const double best = *std::max_element(scores.begin(), scores.end());
+	const double worst = *std::min_element(scores.begin(), scores.end());
+	int k = 1;
+	while (k < most && scores[k - 1] < worst + 0.9 * (best - worst))
+		++k;
+
+	result.cluster = assignments[k - 1];
+	for (int c = 0; c < k; ++c)
+	{
+		long long nearest = -1, clusterInstructions = 0;
+		double nearestDistance = 0;
+		for (size_t i = 0; i < intervals; ++i)
+			if (result.cluster[i] == c)
+			{
+				clusterInstructions += result.lengths[i];
+				double d = simpoint::distance2(x[i], centroids[k - 1][c]);
+				if (nearest < 0 || d < nearestDistance)
+					nearest = i, nearestDistance = d;
+			}
+		if (nearest >= 0)
+			result.points.push_back({nearest, (double)clusterInstructions / result.instructions});
+	}
+	return result;
+}
+
+/*
+	estimated cycles of the whole run on Simulator's pipeline: every representative interval is
+	simulated in detail, after fast-forwarding to it, and its cycles per instruction weighted
+*/
+template <typename Simulator>
+double estimateCycles(std::shared_ptr<const Program> program, const SimPoints &points)
+{
+	std::unique_ptr<Simulator> mips(new Simulator(program));
+	std::ostream discard(nullptr);
+	double cpi = 0;
+	for (const SimPoints::Point &point : points.points)
+	{
+		mips->reset(program);
+		mips->out = mips->err = &discard;
+		mips->fastForward(point.interval * points.intervalSize);
+		mips->fetchBudget = points.lengths[point.interval];
+		cpi += point.weight * mips->executeCommandsPipelined() / points.lengths[point.interval];
+	}
+	return cpi * points.instructions;
+}
+
+// the chosen intervals with their weights
+inline void printSimPoints(const SimPoints &points, std::ostream &out)
+{
+	out << "SimPoint: " << points.instructions << " instructions in " << points.lengths.size() << " intervals of " << points.intervalSize << ", " << points.points.size() << " representatives\n";
+	for (const SimPoints::Point &point : points.points)
+		out << "interval " << point.interval << " (from instruction " << point.interval * points.intervalSize << "): weight " << point.weight << '\n';
+}
+
+#endif
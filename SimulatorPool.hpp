@@ -0,0 +1,58 @@
+/**
+ * @file SimulatorPool.hpp
+ * @brief Simulators kept for reuse, so batches of small programs pay for construction only once
+ *
+ * A simulator taken from the pool is reset() to the new program; returning it makes it available
+ * to the next acquire(), from any thread.
+ */
+
+#ifndef __SIMULATOR_POOL_HPP__
+#define __SIMULATOR_POOL_HPP__
+
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <utility>
+#include "Lexer.hpp"
+
+template <typename Simulator>
+class SimulatorPool
+{
+	std::vector<std::unique_ptr<Simulator>> idle;
+	std::mutex mutex;
+
+public:
+	// a simulator loaded with this source, or running this already loaded program, reused when one is idle
+	template <typename Loaded>
+	std::unique_ptr<Simulator> acquire(Loaded &&loaded)
+	{
+		std::unique_ptr<Simulator> simulator;
+		{
+			std::lock_guard<std::mutex> guard(mutex);
+			if (!idle.empty())
+			{
+				simulator = std::move(idle.back());
+				idle.pop_back();
+			}
+		}
+		if (simulator)
+			simulator->reset(std::forward<Loaded>(loaded));
+		else
+			simulator.reset(new Simulator(std::forward<Loaded>(loaded)));
+		return simulator;
+	}
+
+	void release(std::unique_ptr<Simulator> simulator)
+	{
+		std::lock_guard<std::mutex> guard(mutex);
+		idle.push_back(std::move(simulator));
+	}
+
+	size_t size()
+	{
+		std::lock_guard<std::mutex> guard(mutex);
+		return idle.size();
+	}
+};
+
+#endif
@@ -0,0 +1,117 @@
+/**
+ * @file Smarts.hpp
+ * @brief SMARTS style statistical sampling of a pipelined model's cycles per instruction
+ *
+ * One simulator alternates between functional fast-forward, a detailed warming window that fills the
+ * pipeline and a detailed measurement window of `unit` instructions, whose fetch cycles give one CPI
+ * sample; the pipeline is emptied after each window and the architectural state carries on. The
+ * samples are systematic, a period apart from a random offset. The estimate is their mean with a 95%
+ * confidence interval; when its half width is above the target relative error, the run is repeated
+ * with the number of samples the measured variation calls for, (z V / error)^2.
+ *
+ * The program is translated for fast-forwarding once: resetting the simulator to the same program
+ * keeps its translated code, so every fast-forward after the first runs on it.
+ */
+
+#ifndef __SMARTS_HPP__
+#define __SMARTS_HPP__
+
+#include <cmath>
+#include <memory>
+#include <ostream>
+#include <random>
+#include <vector>
+#include "Program.hpp"
+#include "Jit.hpp"
+
+struct SmartsEstimate
+{
+	static const int INITIAL_SAMPLES = 30;
+	static constexpr double Z = 1.96; // 95% confidence
+
+	double cpi = 0;
+	double halfWidth = 0;		// of the confidence interval
+	long long samples = 0;		// 0 if the program was too short to sample and ran in detail
+	long long instructions = 0; // of the whole run
+	double cycles() const { return cpi * instructions; }
+};
+
+/*
+	estimate Simulator's cycles per instruction on the program to within targetError (relative) by
+	sampling windows of unit instructions, each after warming instructions of detailed simulation
+*/
+template <typename Simulator>
+SmartsEstimate sampleCpi(std::shared_ptr<const Program> program, double targetError, long long unit, long long warming)
+{
+	SmartsEstimate estimate;
+	std::unique_ptr<Simulator> mips(new Simulator(program));
+	std::ostream discard(nullptr);
+	mips->out = mips->err = &discard;
+
+	// length of the run, the windows stop short of a faulting lw/sw, which would end the pipelined run
+	long long total = 0;
+	if (runJit(*mips, mips->jit, mips->threaded, total) == INVALID_ADDRESS)
+		--total;
+	estimate.instructions = total;
+
+	const long long window = warming + unit;
+	const long long most = unit > 0 ? total / window : 0;
+	if (most == 0)
+	{
+		mips->reset(program);
+		mips->fetchBudget = total;
+		estimate.cpi = total ? (double)mips->executeCommandsPipelined() / total : 0;
+		return estimate;
+	}
+
+	std::mt19937 random(1);
+	std::vector<double> cpi;
+	for (long long n = std::min<long long>(SmartsEstimate::INITIAL_SAMPLES, most);;)
+	{
+		mips->reset(program);
+		const long long period = total / n;
+		const long long offset = std::uniform_int_distribution<long long>(0, period - window)(random);
+		long long position = 0;
+		cpi.clear();
+		for (long long j = 0; j < n; ++j)
+		{
+			const long long start = j * period + offset;
+			mips->fastForward(start - position);
+			mips->clearPipeline();
+			mips->fetchBudget = window;
+			mips->measured = unit;
+			mips->executeCommandsPipelined();
+			cpi.push_back((double)mips->measuredCycles / unit);
+			position = start + window;
+		}
+
+		double mean = 0, variance = 0;
+		for (double c : cpi)
+			mean += c;
+		mean /= n;
+		for (double c : cpi)
+			variance += (c - mean) * (c - mean);
+		variance = n > 1 ? variance / (n - 1) : 0;
+		estimate.cpi = mean;
+		estimate.samples = n;
+		estimate.halfWidth = SmartsEstimate::Z * std::sqrt(variance / n);
+		if (estimate.halfWidth <= targetError * mean || n == most)
+			break;
+		// samples for the target error at the variation seen
+		const double needed = std::ceil(SmartsEstimate::Z * SmartsEstimate::Z * variance / (targetError * targetError * mean * mean));
+		n = std::min<long long>(most, std::max<double>(needed, n + 1));
+	}
+	return estimate;
+}
+
+inline void printSmartsEstimate(const char *name, const SmartsEstimate &estimate, long long unit, std::ostream &out)
+{
+	out << name << ": CPI " << estimate.cpi << " +- " << estimate.halfWidth;
+	if (estimate.samples)
+		out << " (95% confidence, " << estimate.samples << " samples of " << unit << " instructions)";
+	else
+		out << " (too short to sample, simulated in full)";
+	out << ", estimated " << std::llround(estimate.cycles()) << " cycles for " << estimate.instructions << " instructions\n";
+}
+
+#endif
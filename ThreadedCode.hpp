@@ -0,0 +1,241 @@
+/**
+ * @file ThreadedCode.hpp
+ * @brief Functional executor over threaded code: every instruction becomes a slot holding the
+ * address of its handler, and each handler jumps straight to the next one (GCC/Clang labels as values)
+ *
+ * It runs the program with the effect of executeCommandsUnpipelined, without its per instruction
+ * output; counting the executions of every instruction (commandCount) is a compile time option.
+ *
+ * Slots are translated a basic block at a time, on the first visit to the block; later visits reuse
+ * them, and so do later runs of the same program through the same ThreadedCode. With fusion, common pairs inside a block (slt or addi followed by a branch, lw followed by
+ * add) share one slot and one dispatch.
+ */
+
+#ifndef __THREADED_CODE_HPP__
+#define __THREADED_CODE_HPP__
+
+#include <vector>
+#include "Program.hpp"
+
+// one instruction, with a branch or jump target already resolved to its slot
+struct ThreadedOp
+{
+	const void *handler = nullptr;
+	const ThreadedOp *jump = nullptr; // of the instruction, or of the branch fused after it
+	int imm = 0;
+	uint8_t r1 = 0, r2 = 0, r3 = 0;
+	uint8_t s1 = 0, s2 = 0, s3 = 0; // registers of the instruction fused after it
+	bool leader = false;			// a basic block starts here
+};
+
+// the threaded code of one program, kept by a simulator across runs until it loads another program
+struct ThreadedCode
+{
+	std::vector<ThreadedOp> ops;
+	const void *const *handlers = nullptr; // of the runThreaded instantiation the slots were built for
+
+	void clear()
+	{
+		ops.clear();
+		handlers = nullptr;
+	}
+};
+
+inline bool isBranch(Opcode op)
+{
+	return op == Opcode::beq || op == Opcode::bne || op == Opcode::j;
+}
+
+/*
+	run the simulator's program from PCcurr until it leaves the program or an lw/sw misses the data
+	segment, code is the simulator's threaded code, built here unless it is already this
+	instantiation's for the program; steps counts the instructions
+	started, as the cycles of executeCommandsUnpipelined do, and PCcurr is left on the faulting one.
+	Bounded runs also stop once limit instructions have run, with PCcurr on the next one; they are
+	never fused, so that they stop on the exact instruction
+*/
+template <bool Profile, bool Fuse = true, bool Bounded = false, typename Simulator>
+exit_code runThreaded(Simulator &m, ThreadedCode &code, long long &steps, long long limit = 0)
+{
+	// indexed by Opcode, end and invalid never reach a verified program
+	static const void *const HANDLERS[] = {&&add, &&sub, &&mul, &&slt, &&addi, &&beq, &&bne, &&j, &&lw, &&sw, &&nop, &&halt, &&halt};
+
+	const std::vector<Instruction> &program = m.program->instructions;
+	const int n = program.size();
+	if (code.handlers != HANDLERS || code.ops.size() != (size_t)n + 1)
+	{
+		code.handlers = HANDLERS;
+		code.ops.assign(n + 1, ThreadedOp());
+		ThreadedOp *const base = code.ops.data();
+		for (int i = 0; i < n; ++i)
+		{
+			const Instruction &ins = program[i];
+			ThreadedOp &op = base[i];
+			op.handler = &&translate;
+			op.imm = ins.imm;
+			op.r1 = ins.r1, op.r2 = ins.r2, op.r3 = ins.r3;
+			if (isBranch(ins.op))
+			{
+				op.jump = base + ins.target;
+				base[ins.target].leader = base[i + 1].leader = true;
+			}
+		}
+		base[n].handler = &&halt;
+	}
+	ThreadedOp *const base = code.ops.data();
+	// a run may start inside a block, slots already translated past that point stay as they are
+	base[m.PCcurr].leader = true;
+
+	int *const r = m.registers;
+	int *const data = m.data;
+	int *const counts = m.commandCount.data();
+	const ThreadedOp *ip = base + m.PCcurr;
+	long long started = 0;
+	int address = 0;
+
+// count the instruction that just ran, then go to the handler of the next one
+#define THREADED_NEXT(following)           \
+	do                                     \
+	{                                      \
+		if constexpr (Profile)             \
+			++counts[ip - base];           \
+		ip = (following);                  \
+		if constexpr (Bounded)             \
+			if (started == limit)          \
+				goto halt;                 \
+		goto *ip->handler;                 \
+	} while (0)
+
+	goto *ip->handler;
+
+// first visit to a block: translate it up to its branch or the next block, then run it
+translate:
+	for (ThreadedOp *slot = base + (ip - base);; ++slot)
+	{
+		const int i = slot - base;
+		const Opcode op = program[i].op;
+		slot->handler = HANDLERS[(int)op];
+		if (Fuse && !Bounded && i + 1 < n && !slot[1].leader)
+		{
+			const Instruction &second = program[i + 1];
+			const void *pair = nullptr;
+			if (op == Opcode::slt)
+				pair = second.op == Opcode::bne ? &&slt_bne : second.op == Opcode::beq ? &&slt_beq : nullptr;
+			else if (op == Opcode::addi)
+				pair = second.op == Opcode::bne ? &&addi_bne : second.op == Opcode::beq ? &&addi_beq : nullptr;
+			else if (op == Opcode::lw && second.op == Opcode::add)
+				pair = &&lw_add;
+			if (pair)
+			{
+				slot->handler = pair;
+				slot->s1 = second.r1, slot->s2 = second.r2, slot->s3 = second.r3;
+				if (isBranch(second.op))
+					slot->jump = base + second.target;
+			}
+		}
+		if (isBranch(op) || i + 1 == n || slot[1].leader)
+			break;
+	}
+	goto *ip->handler;
+
+add:
+	++started;
+	r[ip->r1] = r[ip->r2] + r[ip->r3];
+	THREADED_NEXT(ip + 1);
+sub:
+	++started;
+	r[ip->r1] = r[ip->r2] - r[ip->r3];
+	THREADED_NEXT(ip + 1);
+mul:
+	++started;
+	r[ip->r1] = r[ip->r2] * r[ip->r3];
+	THREADED_NEXT(ip + 1);
+slt:
+	++started;
+	r[ip->r1] = r[ip->r2] < r[ip->r3];
+	THREADED_NEXT(ip + 1);
+addi:
+	++started;
+	r[ip->r1] = r[ip->r2] + ip->imm;
+	THREADED_NEXT(ip + 1);
+beq:
+	++started;
+	THREADED_NEXT(r[ip->r1] == r[ip->r2] ? ip->jump : ip + 1);
+bne:
+	++started;
+	THREADED_NEXT(r[ip->r1] != r[ip->r2] ? ip->jump : ip + 1);
+j:
+	++started;
+	THREADED_NEXT(ip->jump);
+lw:
+	++started;
+	address = m.locateAddress(r[ip->r2] + ip->imm);
+	if (address < 0)
+		goto fault;
+	r[ip->r1] = data[address];
+	THREADED_NEXT(ip + 1);
+sw:
+	++started;
+	address = m.locateAddress(r[ip->r2] + ip->imm);
+	if (address < 0)
+		goto fault;
+	data[address] = r[ip->r1];
+	m.dirtyPages.mark(address);
+	THREADED_NEXT(ip + 1);
+nop:
+	++started;
+	THREADED_NEXT(ip + 1);
+
+// fused pairs, both instructions are counted
+#define THREADED_NEXT_PAIR(following)      \
+	do                                     \
+	{                                      \
+		if constexpr (Profile)             \
+		{                                  \
+			++counts[ip - base];           \
+			++counts[ip - base + 1];       \
+		}                                  \
+		ip = (following);                  \
+		goto *ip->handler;                 \
+	} while (0)
+
+slt_bne:
+	started += 2;
+	r[ip->r1] = r[ip->r2] < r[ip->r3];
+	THREADED_NEXT_PAIR(r[ip->s1] != r[ip->s2] ? ip->jump : ip + 2);
+slt_beq:
+	started += 2;
+	r[ip->r1] = r[ip->r2] < r[ip->r3];
+	THREADED_NEXT_PAIR(r[ip->s1] == r[ip->s2] ? ip->jump : ip + 2);
+addi_bne:
+	started += 2;
+	r[ip->r1] = r[ip->r2] + ip->imm;
+	THREADED_NEXT_PAIR(r[ip->s1] != r[ip->s2] ? ip->jump : ip + 2);
+addi_beq:
+	started += 2;
+	r[ip->r1] = r[ip->r2] + ip->imm;
+	THREADED_NEXT_PAIR(r[ip->s1] == r[ip->s2] ? ip->jump : ip + 2);
+lw_add:
+	++started;
+	address = m.locateAddress(r[ip->r2] + ip->imm);
+	if (address < 0)
+		goto fault;
+	++started;
+	r[ip->r1] = data[address];
+	r[ip->s1] = r[ip->s2] + r[ip->s3];
+	THREADED_NEXT_PAIR(ip + 2);
+
+#undef THREADED_NEXT
+#undef THREADED_NEXT_PAIR
+
+fault:
+	m.PCcurr = m.PCnext = ip - base;
+	steps += started;
+	return INVALID_ADDRESS;
+halt:
+	m.PCcurr = m.PCnext = ip - base;
+	steps += started;
+	return SUCCESS;
+}
+
+#endif
@@ -0,0 +1,215 @@
+/**
+ * @file TimingMemo.hpp
+ * @brief Timing memoization: the cycles a pipelined model spends on a basic block depend only on the
+ * block, on the pipeline's state as the block is entered and on where its branch goes, so loops are
+ * simulated in detail once per distinct entry and their timing replayed afterwards
+ *
+ * The pipeline runs timing only (outcomes): a functional run executes every block as the pipeline
+ * fetches its first instruction and hands it the outcome of the block's branch and whether each of
+ * its lw/sw faults, so no value in the pipeline matters. A block's key is the timing state just after
+ * that fetch (timingSignature) with the block it is left for and whether it faults; its entry holds
+ * the cycles until the next block is fetched and the timing state then. A hit restores that state
+ * and adds the cycles without simulating them, a miss simulates the block cycle by cycle and
+ * records it.
+ *
+ * The pipeline follows the program's path as the functional run takes it, and the functional run
+ * follows the PCs the pipeline fetches; a faulting lw/sw leaves memory and registers as they were,
+ * and the run ends once it reaches the pipeline's memory stage.
+ */
+
+#ifndef __TIMING_MEMO_HPP__
+#define __TIMING_MEMO_HPP__
+
+#include <climits>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Program.hpp"
+#include "ThreadedCode.hpp"
+
+struct MemoizedTiming
+{
+	static const size_t MAX_ENTRIES = 1 << 16; // the table starts over once it holds this many blocks
+
+	long long cycles = 0;
+	long long blocks = 0, hits = 0; // blocks entered, and replayed from the table
+	size_t entries = 0;
+	long long fullCycles = -1; // of executeCommandsPipelined, when validated
+};
+
+namespace memo
+{
+	/*
+		run m's program functionally from pc to the end of the block: its branch, or the instruction
+		before the next block; returns the PC it continues at, leaves the last one run in end and sets
+		faulted if an lw/sw in it did
+	*/
+	template <typename Simulator>
+	int runBlock(Simulator &m, const std::vector<Instruction> &program, const std::vector<char> &leader, int pc, int &end, bool &faulted, char *outcomes)
+	{
+		faulted = false;
+		int *const r = m.registers;
+		const int n = program.size();
+		for (;; ++pc)
+		{
+			const Instruction &ins = program[pc];
+			int address;
+			switch (ins.op)
+			{
+			case Opcode::add:
+			case Opcode::sub:
+			case Opcode::mul:
+			case Opcode::slt:
+				r[ins.r1] = Simulator::alu(ins.op, r[ins.r2], r[ins.r3]);
+				break;
+			case Opcode::addi:
+				r[ins.r1] = r[ins.r2] + ins.imm;
+				break;
+			case Opcode::beq:
+			case Opcode::bne:
+				end = pc;
+				outcomes[pc] = (r[ins.r1] == r[ins.r2]) == (ins.op == Opcode::beq);
+				return outcomes[pc] ? ins.target : pc + 1;
+			case Opcode::j:
+				end = pc;
+				return ins.target;
+			case Opcode::lw:
+			case Opcode::sw:
+				address = m.locateAddress(r[ins.r2] + ins.imm);
+				outcomes[pc] = address < 0;
+				faulted |= address < 0;
+				if (address < 0)
+					break;
+				if (ins.op == Opcode::lw)
+					r[ins.r1] = m.data[address];
+				else
+					m.data[address] = r[ins.r1];
+				break;
+			default:
+				break;
+			}
+			if (pc + 1 == n || leader[pc + 1])
+			{
+				end = pc;
+				return pc + 1;
+			}
+		}
+	}
+}
+
+/*
+	cycles of Simulator's pipeline on the program, its basic blocks replayed from a table of earlier
+	timings when they are entered in a state seen before; validating also runs the program through
+	executeCommandsPipelined, for fullCycles to compare against
+*/
+template <typename Simulator>
+MemoizedTiming memoizedCycles(std::shared_ptr<const Program> program, bool validate)
+{
+	MemoizedTiming result;
+	std::ostream discard(nullptr);
+	std::unique_ptr<Simulator> timing(new Simulator(program)), functional(new Simulator(program));
+	timing->out = timing->err = &discard;
+
+	const std::vector<Instruction> &instructions = program->instructions;
+	const int n = instructions.size();
+	std::vector<char> leader(n + 1, 0), outcomes(n + 1, 0);
+	leader[program->entry] = leader[n] = 1;
+	for (int i = 0; i < n; ++i)
+		if (isBranch(instructions[i].op))
+			leader[instructions[i].target] = leader[i + 1] = 1;
+
+	struct Entry
+	{
+		long long cycles;
+		typename Simulator::TimingState exit;
+	};
+	std::unordered_map<std::string, Entry> table;
+	std::string key, open; // of the block being simulated in detail, if openedAt is set
+	long long openedAt = -1;
+	timing->outcomes = outcomes.data();
+	timing->fetchBudget = LLONG_MAX; // only to see the fetches, a refetched unresolved branch is not one
+	int last = -1;					 // PC of the last fetch
+	bool entered = false;			 // the last fetch started a block
+
+	while (!timing->pipelineEnded())
+	{
+		if (!entered)
+		{
+			const long long budget = timing->fetchBudget;
+			timing->cycle();
+			++result.cycles;
+			if (timing->pipelineIdle() || timing->faultAt >= 0)
+				break;
+			if (timing->fetchBudget == budget)
+				continue;
+			entered = leader[timing->PCcurr] || timing->PCcurr != last + 1;
+			last = timing->PCcurr;
+			if (!entered)
+				continue;
+		}
+		entered = false;
+
+		if (openedAt >= 0)
+		{
+			if (table.size() == MemoizedTiming::MAX_ENTRIES)
+				table.clear();
+			Entry &entry = table[open];
+			entry.cycles = result.cycles - openedAt;
+			timing->saveTiming(entry.exit);
+			openedAt = -1;
+		}
+
+		// the block was fetched before the functional run gave its outcomes
+		const int pc = timing->PCcurr;
+		int end = pc;
+		bool faulted;
+		const int successor = memo::runBlock(*functional, instructions, leader, pc, end, faulted, outcomes.data());
+		timing->tagOutcome(timing->fetched());
+		++result.blocks;
+
+		key.clear();
+		timing->timingSignature(key);
+		key.append((const char *)&successor, sizeof(successor));
+		key.push_back(outcomes[end]);
+		key.push_back(faulted);
+		auto hit = table.find(key);
+		if (hit == table.end())
+		{
+			open.swap(key);
+			openedAt = result.cycles;
+			continue;
+		}
+		++result.hits;
+		timing->restoreTiming(hit->second.exit);
+		result.cycles += hit->second.cycles;
+		last = timing->PCcurr;
+		entered = true;
+	}
+	result.entries = table.size();
+
+	if (validate)
+	{
+		std::unique_ptr<Simulator> full(new Simulator(program));
+		full->out = full->err = &discard;
+		result.fullCycles = full->executeCommandsPipelined();
+	}
+	return result;
+}
+
+inline void printMemoizedTiming(const char *name, const MemoizedTiming &timing, std::ostream &out)
+{
+	out << name << ": " << timing.cycles << " cycles, " << timing.hits << " of " << timing.blocks << " blocks replayed from " << timing.entries << " timings";
+	if (timing.fullCycles >= 0)
+	{
+		out << "; executeCommandsPipelined: " << timing.fullCycles << " cycles, ";
+		if (timing.fullCycles == timing.cycles)
+			out << "match";
+		else
+			out << "off by " << timing.cycles - timing.fullCycles;
+	}
+	out << '\n';
+}
+
+#endif
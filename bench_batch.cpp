@@ -0,0 +1,58 @@
+/**
+ * @file bench_batch.cpp
+ * @brief Batch throughput: programs/sec running the same small program back to back on freshly
+ * constructed simulators and on simulators reset() from a SimulatorPool
+ *
+ * ./bench_batch <file name> [runs] (see `make batch_bench`), the runs' output is discarded
+ */
+
+#include <chrono>
+#include <sstream>
+#include "5stage.hpp"
+#include "SimulatorPool.hpp"
+
+template <typename F>
+void report(const char *name, long runs, F run)
+{
+	auto start = std::chrono::steady_clock::now();
+	for (long i = 0; i < runs; ++i)
+		run();
+	double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::cerr << name << ": " << runs / s << " programs/sec (" << s / runs * 1e6 << " us per program)\n";
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc < 2)
+	{
+		std::cerr << "Required argument: file_name\n./bench_batch <file name> [runs]\n";
+		return 0;
+	}
+	long runs = argc > 2 ? atol(argv[2]) : 10000;
+	std::ostringstream discard;
+	std::streambuf *out = std::cout.rdbuf(discard.rdbuf());
+	auto open = [&]()
+	{
+		SourceText source;
+		source.open(argv[1]);
+		return source;
+	};
+
+	report("new + delete", runs, [&]()
+		   {
+			   MIPS_5Stage *mips = new MIPS_5Stage(open());
+			   mips->executeCommandsUnpipelined();
+			   delete mips;
+			   discard.str(""); });
+
+	SimulatorPool<MIPS_5Stage> pool;
+	report("pool + reset", runs, [&]()
+		   {
+			   std::unique_ptr<MIPS_5Stage> mips = pool.acquire(open());
+			   mips->executeCommandsUnpipelined();
+			   pool.release(std::move(mips));
+			   discard.str(""); });
+
+	std::cout.rdbuf(out);
+	return 0;
+}
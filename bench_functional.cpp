@@ -0,0 +1,129 @@
+/**
+ * @file bench_functional.cpp
+ * @brief Functional execution speed: instructions/sec of executeCommandsUnpipelined (output discarded)
+ * against the threaded code executor, with and without counting every instruction and fusing pairs,
+ * and against the hot blocks translated to host code
+ *
+ * ./bench_functional <file name> [iterations], the file is generated as a loop kernel running that many
+ * iterations when it does not exist (see `make functional_bench`)
+ */
+
+#include <chrono>
+#include <fstream>
+#include <streambuf>
+#include "5stage.hpp"
+
+// a loop over an array element with every instruction type in its body, and each fused pair
+void generate(const char *fileName, long iterations)
+{
+	std::ofstream out(fileName);
+	out << "\taddi $s0, $zero, " << iterations << "\n";
+	out << "\taddi $s1, $zero, 4096\n";
+	out << "loop:\n";
+	out << "\taddi $t0, $t0, 1\n";
+	out << "\tadd $t1, $t1, $t0\n";
+	out << "\tsw $t1, 0($s1)\n";
+	out << "\tlw $t2, 0($s1)\n";
+	out << "\tadd $t3, $t2, $t0\n";
+	out << "\tmul $t5, $t3, $t0\n";
+	out << "\tslt $t4, $t3, $t1\n";
+	out << "\tbne $t4, $zero, skip\n";
+	out << "\tsub $t5, $t3, $t1\n";
+	out << "skip:\n";
+	out << "\taddi $s0, $s0, -1\n";
+	out << "\tbne $s0, $zero, loop\n";
+}
+
+// output sink that formats as usual and drops the characters, counting them, so the trace costs no memory
+struct CountingBuffer : std::streambuf
+{
+	long long bytes = 0;
+
+	int overflow(int c) override
+	{
+		++bytes;
+		return traits_type::not_eof(c);
+	}
+
+	std::streamsize xsputn(const char *, std::streamsize n) override
+	{
+		bytes += n;
+		return n;
+	}
+};
+
+// run returns how many instructions it executed, repeated until a second has passed
+template <typename F>
+void report(const char *name, F run)
+{
+	long long instructions = 0;
+	double s = 0;
+	auto start = std::chrono::steady_clock::now();
+	while (s < 1)
+	{
+		instructions += run();
+		s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+	std::cerr << name << ": " << instructions / s / 1e6 << " M instructions/sec\n";
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc < 2)
+	{
+		std::cerr << "Required argument: file_name\n./bench_functional <file name> [iterations]\n";
+		return 0;
+	}
+	if (access(argv[1], F_OK) != 0)
+		generate(argv[1], argc > 2 ? atol(argv[2]) : 1000000);
+
+	SourceText source;
+	if (!source.open(argv[1]))
+	{
+		std::cerr << "File could not be opened. Terminating...\n";
+		return 0;
+	}
+	auto program = std::make_shared<const Program>(std::move(source));
+	std::unique_ptr<MIPS_5Stage> mips(new MIPS_5Stage(program));
+	CountingBuffer counted;
+	std::ostream discard(&counted);
+	mips->out = &discard;
+	auto executed = [&]()
+	{
+		long long n = 0;
+		for (int c : mips->commandCount)
+			n += c;
+		return n;
+	};
+
+	report("executeCommandsUnpipelined", [&]()
+		   {
+			   mips->reset(program);
+			   mips->executeCommandsUnpipelined();
+			   return executed(); });
+	report("threaded code, counting", [&]()
+		   {
+			   mips->reset(program);
+			   mips->executeCommandsFunctional(true);
+			   return executed(); });
+	long long steps = 0;
+	report("threaded code, fused", [&]()
+		   {
+			   mips->reset(program);
+			   steps = 0;
+			   runThreaded<false, true>(*mips, mips->threaded, steps);
+			   return steps; });
+	report("threaded code, unfused", [&]()
+		   {
+			   mips->reset(program);
+			   steps = 0;
+			   runThreaded<false, false>(*mips, mips->threaded, steps);
+			   return steps; });
+	report("jit", [&]()
+		   {
+			   mips->reset(program);
+			   steps = 0;
+			   runJit(*mips, mips->jit, mips->threaded, steps);
+			   return steps; });
+	return 0;
+}
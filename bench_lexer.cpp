@@ -0,0 +1,110 @@
+/**
+ * @file bench_lexer.cpp
+ * @brief Load throughput: lines/sec of getline + boost::tokenizer against the mapped string_view lexer,
+ * and of a full load with and without the cached program image
+ *
+ * ./bench_lexer <file name> [lines], the file is generated with that many lines when it does not exist
+ * (see `make lexer_bench`)
+ */
+
+#include <chrono>
+#include <fstream>
+#include <boost/tokenizer.hpp>
+#include "5stage.hpp"
+
+// a loop body with labels, comments and every operand form, repeated with fresh label names
+void generate(const char *fileName, long lines)
+{
+	std::ofstream out(fileName);
+	for (long i = 0; i < lines;)
+	{
+		out << "L" << i << ":\n";
+		out << "\taddi $t0, $t0, 1 # count\n";
+		out << "\tadd $t1, $t1, $t0\n";
+		out << "\tsub $t2, $t1, $t0\n";
+		out << "\tmul $t3, $t2, $t2\n";
+		out << "\tslt $t4, $t0, $t3\n";
+		out << "\tsw $t1, 4($sp)\n";
+		out << "\tlw $t5, 4($sp)\n";
+		out << "\n";
+		out << "\tbne $t0, $t5, L" << i << "\n";
+		out << "# comment only line\n";
+		out << "M" << i << ": beq $t0, $zero, L" << i << "\n";
+		i += 12;
+	}
+}
+
+// run returns how many tokens or commands it produced
+template <typename F>
+void report(const char *name, const char *unit, long lines, F run)
+{
+	auto start = std::chrono::steady_clock::now();
+	long count = run();
+	double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::cout << name << ": " << lines / s / 1e6 << " M lines/sec (" << count << ' ' << unit << ", " << s << " s)\n";
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc < 2)
+	{
+		std::cerr << "Required argument: file_name\n./bench_lexer <file name> [lines]\n";
+		return 0;
+	}
+	if (access(argv[1], F_OK) != 0)
+		generate(argv[1], argc > 2 ? atol(argv[2]) : 10000000);
+
+	long lines = 0;
+	{
+		SourceText source;
+		source.open(argv[1]);
+		std::string_view text = source.text();
+		lines = std::count(text.begin(), text.end(), '\n');
+	}
+
+	report("getline + boost::tokenizer", "tokens", lines, [&]()
+		   {
+			   std::ifstream file(argv[1]);
+			   std::string line;
+			   long tokens = 0;
+			   while (getline(file, line))
+			   {
+				   line = line.substr(0, line.find('#'));
+				   std::vector<std::string> command;
+				   boost::tokenizer<boost::char_separator<char>> tok(line, boost::char_separator<char>(", \t"));
+				   for (auto &s : tok)
+					   command.push_back(s);
+				   tokens += command.size();
+			   }
+			   return tokens; });
+
+	report("mmap + string_view", "tokens", lines, [&]()
+		   {
+			   SourceText source;
+			   source.open(argv[1]);
+			   std::string_view text = source.text();
+			   std::vector<std::string_view> command;
+			   long tokens = 0;
+			   while (!text.empty())
+			   {
+				   std::string_view line = nextLine(text);
+				   tokenize(line.substr(0, line.find('#')), command);
+				   tokens += command.size();
+			   }
+			   return tokens; });
+
+	// the first load parses and writes the image, the second one maps it
+	auto load = [&]()
+	{
+		SourceText source;
+		source.open(argv[1]);
+		MIPS_5Stage *mips = new MIPS_5Stage(std::move(source));
+		long commands = mips->program->commands.size();
+		delete mips;
+		return commands;
+	};
+	remove(imagePath(argv[1]).c_str());
+	report("full load (lex, labels, decode, verify, write image)", "commands", lines, load);
+	report("cached load (hash, map image)", "commands", lines, load);
+	return 0;
+}
@@ -0,0 +1,112 @@
+/**
+ * @file bench_stages.cpp
+ * @brief Per-stage microbenchmark: every stage is fed the instructions of a program in turn
+ *
+ * Build against one model with -DBENCH_5STAGE, -DBENCH_5STAGE_BYPASS, -DBENCH_79STAGE or
+ * -DBENCH_79STAGE_BYPASS (see `make bench`), then run ./bench_<model> <file name> [iterations]
+ */
+
+#include <chrono>
+
+#if defined(BENCH_5STAGE)
+#include "5stage.hpp"
+typedef MIPS_5Stage MIPS_Architecture;
+#elif defined(BENCH_5STAGE_BYPASS)
+#include "5stage_bypass.hpp"
+typedef MIPS_5StageBypass MIPS_Architecture;
+#elif defined(BENCH_79STAGE)
+#include "79stage.hpp"
+typedef MIPS_79Stage MIPS_Architecture;
+#elif defined(BENCH_79STAGE_BYPASS)
+#include "79stage_bypass.hpp"
+typedef MIPS_79StageBypass MIPS_Architecture;
+#else
+#error "define one of BENCH_5STAGE, BENCH_5STAGE_BYPASS, BENCH_79STAGE, BENCH_79STAGE_BYPASS"
+#endif
+
+// time one stage over `iterations` calls, `feed` loads the input latch for the i-th call
+template <typename Feed, typename Stage>
+void bench(const char *name, MIPS_Architecture &mips, long iterations, Feed feed, Stage stage)
+{
+	const int n = mips.program->instructions.size();
+	int pc = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (long i = 0; i < iterations; ++i, pc = pc + 1 == n ? 0 : pc + 1)
+	{
+		const Instruction &ins = mips.program->instructions[pc];
+		mips.scoreboard.update(ins.r1, 0), mips.scoreboard.update(ins.r2, 0), mips.scoreboard.update(ins.r3, 0);
+		mips.scoreboard.releasing = 0;
+		mips.memoryDelta.clear();
+		mips.proceed = true;
+		mips.PCcurr = 0;
+		feed(ins, pc);
+		stage();
+	}
+	double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+	std::cout << name << ": " << ns / iterations << " ns/call\n";
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc < 2)
+	{
+		std::cerr << "Required argument: file_name\n./bench_<model> <file name> [iterations]\n";
+		return 0;
+	}
+	SourceText source;
+	if (!source.open(argv[1]))
+	{
+		std::cerr << "File could not be opened. Terminating...\n";
+		return 0;
+	}
+	MIPS_Architecture *mips = new MIPS_Architecture(std::move(source));
+	if (mips->program->instructions.empty())
+		return 0;
+	long iterations = argc > 2 ? atol(argv[2]) : 10000000;
+	MIPS_Architecture &m = *mips;
+	const int word = 1000;
+
+	// every stage runs once per cycle, the 5 stage ones read the current latches and fill the next
+	auto once = [&](void (MIPS_Architecture::*stage)())
+	{
+		return [&m, stage]()
+		{ (m.*stage)(); };
+	};
+
+#if defined(BENCH_5STAGE) || defined(BENCH_5STAGE_BYPASS)
+	bench("instructionFetch", m, iterations, [&](const Instruction &, int pc)
+		  { m.branchStall = false, m.PCnext = pc; }, once(&MIPS_Architecture::instructionFetch));
+	bench("instructionDecode", m, iterations, [&](const Instruction &ins, int)
+		  { m.branchStall = false, m.now().id.valid = true, m.now().id.command = ins; }, once(&MIPS_Architecture::instructionDecode));
+	bench("execute", m, iterations, [&](const Instruction &ins, int)
+		  { m.now().ex.valid = true, m.now().ex.command = ins, m.now().ex.s1_val = 3, m.now().ex.s2_val = 5; }, once(&MIPS_Architecture::execute));
+	bench("memory", m, iterations, [&](const Instruction &ins, int)
+		  { m.now().mem.valid = true, m.now().mem.command = ins, m.now().mem.computed_value = word; }, once(&MIPS_Architecture::memory));
+	bench("writeBack", m, iterations, [&](const Instruction &ins, int)
+		  { m.now().wb.valid = true, m.now().wb.command = ins, m.now().wb.computed_value = 7; }, once(&MIPS_Architecture::writeBack));
+#else
+	bench("instructionFetch1", m, iterations, [&](const Instruction &, int pc)
+		  { m.branchStall = false, m.PCnext = pc; }, once(&MIPS_Architecture::instructionFetch1));
+	bench("instructionFetch2", m, iterations, [&](const Instruction &ins, int)
+		  { m.branchStall = false, m.if2.valid = true, m.if2.command = ins; }, once(&MIPS_Architecture::instructionFetch2));
+	bench("instructionDecode1", m, iterations, [&](const Instruction &ins, int)
+		  { m.id1.valid = true, m.id1.command = ins; }, once(&MIPS_Architecture::instructionDecode1));
+	bench("instructionDecode2", m, iterations, [&](const Instruction &ins, int)
+		  { m.id2.valid = true, m.id2.command = ins; }, once(&MIPS_Architecture::instructionDecode2));
+	bench("registerReadRtype", m, iterations, [&](const Instruction &ins, int)
+		  { m.rr.valid = true, m.rr.command = ins; }, once(&MIPS_Architecture::registerReadRtype));
+	bench("registerReadItype", m, iterations, [&](const Instruction &ins, int)
+		  { m.rr.valid = true, m.rr.command = ins; }, once(&MIPS_Architecture::registerReadItype));
+	bench("executeRtype", m, iterations, [&](const Instruction &ins, int)
+		  { m.exRtype.valid = true, m.exRtype.command = ins, m.exRtype.s1_val = 3, m.exRtype.s2_val = 5; }, once(&MIPS_Architecture::executeRtype));
+	bench("executeItype", m, iterations, [&](const Instruction &ins, int)
+		  { m.exItype.valid = true, m.exItype.command = ins; }, once(&MIPS_Architecture::executeItype));
+	bench("memory1", m, iterations, [&](const Instruction &ins, int)
+		  { m.mem1.valid = true, m.mem1.command = ins, m.mem1.computed_value = word; }, once(&MIPS_Architecture::memory1));
+	bench("memory2", m, iterations, [&](const Instruction &ins, int)
+		  { m.mem2.valid = true, m.mem2.command = ins, m.mem2.computed_value = word; }, once(&MIPS_Architecture::memory2));
+	bench("writeBack", m, iterations, [&](const Instruction &ins, int)
+		  { m.lastWrite = 0, m.wbRtype.valid = m.wbItype.valid = true, m.wbRtype.command = m.wbItype.command = ins, m.wbRtype.insNo = m.wbItype.insNo = 1; }, once(&MIPS_Architecture::writeBack));
+#endif
+	return 0;
+}
@@ -0,0 +1,265 @@
+/**
+ * @file mips.cpp
+ * @brief One driver for every pipeline model: the program is loaded once and the selected models
+ * run it concurrently, a thread each, sharing the read only decoded program
+ *
+ * ./mips [--model=5stage|5stage_bypass|79stage|79stage_bypass|all] [--stats] [--skip-idle] [--expand-idle] [--fast-forward=N] [--simpoint=INTERVAL [--max-clusters=K]]
+ *        [--smarts=ERROR [--smarts-unit=U] [--smarts-warming=W]] [--memoize|--memoize-validate] [--functional] <file name>
+ * A single model prints exactly what its own binary prints. With several, every model writes to a
+ * temporary file of its own in $TMPDIR (else /tmp), printed once all have finished, in the order
+ * above, under a header.
+ * --stats reports the pipeline occupancy of every cycle to stderr after the run. --skip-idle prints
+ * only the cycles that change a register or memory, with a line for each run of idle cycles between
+ * them; --expand-idle prints those runs in full, so the output is the same as without either option.
+ * Both still simulate every cycle, they save the formatting and writing of the idle ones.
+ * --fast-forward=N runs the first N instructions functionally and simulates the pipeline from the
+ * registers, data and PC they leave; the cycles and counts reported are those of the pipelined part.
+ * --simpoint=INTERVAL runs the program functionally in intervals of that many instructions, picks up
+ * to K (10) representative intervals (SimPoint.hpp) and prints, instead of the cycle by cycle output,
+ * the cycles of the whole run every model is estimated to take from simulating only those.
+ * --smarts=ERROR samples every model's CPI (Smarts.hpp) in windows of U (1000) instructions after W
+ * (100) of warming, taking as many samples as a 95% confidence interval within ERROR (e.g. 0.02)
+ * of the estimate needs, and prints the CPI, its interval and the cycles it implies.
+ * --memoize runs every model timing only, replaying the cycles of basic blocks entered in a pipeline
+ * state seen before (TimingMemo.hpp), and prints the cycles; --memoize-validate also runs the full
+ * pipeline and reports whether its cycles match.
+ * --functional runs the program at full speed (Jit.hpp) instead of through the pipeline and prints
+ * the final registers and the exit report, with the instructions run in place of the cycles.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <unistd.h>
+#include "5stage.hpp"
+#include "5stage_bypass.hpp"
+#include "79stage.hpp"
+#include "79stage_bypass.hpp"
+#include "SimPoint.hpp"
+#include "Smarts.hpp"
+#include "TimingMemo.hpp"
+
+static const char USAGE[] = "./mips [--model=5stage|5stage_bypass|79stage|79stage_bypass|all] [--stats] [--skip-idle] [--expand-idle] [--fast-forward=N] [--simpoint=INTERVAL [--max-clusters=K]] [--smarts=ERROR [--smarts-unit=U] [--smarts-warming=W]] [--memoize|--memoize-validate] [--functional] <file name>\n";
+
+struct Options
+{
+	bool stats = false;
+	bool skipIdle = false;
+	bool expandIdle = false;
+	long long fastForward = 0; // instructions run functionally before the pipeline starts
+	long long simpointInterval = 0;
+	int maxClusters = 10;
+	double smartsError = 0; // target relative error of the sampled CPI, 0 to simulate everything
+	long long smartsUnit = 1000, smartsWarming = 100;
+	bool memoize = false, validateMemo = false;
+	bool functional = false; // the final registers only, run at full speed instead of through the pipeline
+};
+
+typedef void (*RunModel)(std::shared_ptr<const Program> program, std::ostream &out, std::ostream &err, Options options);
+typedef double (*EstimateModel)(std::shared_ptr<const Program> program, const SimPoints &points);
+typedef SmartsEstimate (*SampleModel)(std::shared_ptr<const Program> program, double targetError, long long unit, long long warming);
+typedef MemoizedTiming (*MemoizeModel)(std::shared_ptr<const Program> program, bool validate);
+
+template <typename Simulator>
+void runModel(std::shared_ptr<const Program> program, std::ostream &out, std::ostream &err, Options options)
+{
+	std::unique_ptr<Simulator> mips(new Simulator(std::move(program)));
+	mips->out = &out;
+	mips->err = &err;
+	mips->skipIdle = options.skipIdle || options.expandIdle;
+	mips->expandIdle = options.expandIdle;
+	if (options.functional)
+	{
+		mips->executeCommandsJit();
+		return;
+	}
+	if (options.fastForward > 0)
+		err << "Fast-forwarded " << mips->fastForward(options.fastForward) << " instructions\n";
+	mips->executeCommandsPipelined();
+	if (options.stats)
+		mips->printOccupancy();
+}
+
+struct Model
+{
+	const char *name;
+	RunModel run;
+	EstimateModel estimate;
+	SampleModel sample;
+	MemoizeModel memoize;
+};
+
+static const Model MODELS[] = {
+	{"5stage", runModel<MIPS_5Stage>, estimateCycles<MIPS_5Stage>, sampleCpi<MIPS_5Stage>, memoizedCycles<MIPS_5Stage>},
+	{"5stage_bypass", runModel<MIPS_5StageBypass>, estimateCycles<MIPS_5StageBypass>, sampleCpi<MIPS_5StageBypass>, memoizedCycles<MIPS_5StageBypass>},
+	{"79stage", runModel<MIPS_79Stage>, estimateCycles<MIPS_79Stage>, sampleCpi<MIPS_79Stage>, memoizedCycles<MIPS_79Stage>},
+	{"79stage_bypass", runModel<MIPS_79StageBypass>, estimateCycles<MIPS_79StageBypass>, sampleCpi<MIPS_79StageBypass>, memoizedCycles<MIPS_79StageBypass>},
+};
+
+// output of one model while it runs next to the others
+struct ModelOutput
+{
+	std::string path;
+	std::ofstream out;
+	std::ostringstream err;
+};
+
+int main(int argc, char *argv[])
+{
+	std::string model = "all";
+	const char *fileName = nullptr;
+	Options options;
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		if (arg.compare(0, 8, "--model=") == 0)
+			model = arg.substr(8);
+		else if (arg == "--stats")
+			options.stats = true;
+		else if (arg == "--skip-idle")
+			options.skipIdle = true;
+		else if (arg == "--expand-idle")
+			options.expandIdle = true;
+		else if (arg.compare(0, 15, "--fast-forward=") == 0)
+			options.fastForward = atoll(arg.c_str() + 15);
+		else if (arg.compare(0, 11, "--simpoint=") == 0)
+			options.simpointInterval = atoll(arg.c_str() + 11);
+		else if (arg.compare(0, 15, "--max-clusters=") == 0)
+			options.maxClusters = std::max(1, atoi(arg.c_str() + 15));
+		else if (arg.compare(0, 9, "--smarts=") == 0)
+			options.smartsError = atof(arg.c_str() + 9);
+		else if (arg.compare(0, 14, "--smarts-unit=") == 0)
+			options.smartsUnit = std::max(1LL, atoll(arg.c_str() + 14));
+		else if (arg.compare(0, 17, "--smarts-warming=") == 0)
+			options.smartsWarming = std::max(0LL, atoll(arg.c_str() + 17));
+		else if (arg == "--memoize")
+			options.memoize = true;
+		else if (arg == "--memoize-validate")
+			options.memoize = options.validateMemo = true;
+		else if (arg == "--functional")
+			options.functional = true;
+		else if (arg.compare(0, 2, "--") == 0 || fileName != nullptr)
+		{
+			// a mistyped option or a second file would otherwise be dropped silently
+			std::cerr << "Unknown option or extra argument: " << arg << '\n' << USAGE;
+			return 0;
+		}
+		else
+			fileName = argv[i];
+	}
+	std::vector<const Model *> selected;
+	for (const Model &m : MODELS)
+		if (model == "all" || model == m.name)
+			selected.push_back(&m);
+	if (selected.empty())
+	{
+		std::cerr << "Unknown model: " << model << '\n' << USAGE;
+		return 0;
+	}
+	if (fileName == nullptr)
+	{
+		std::cerr << "Required argument: file_name\n" << USAGE;
+		return 0;
+	}
+
+	SourceText source;
+	if (!source.open(fileName))
+	{
+		std::cerr << "File could not be opened. Terminating...\n";
+		return 0;
+	}
+	auto program = std::make_shared<const Program>(std::move(source));
+
+	// a program that cannot run has no intervals, the models report it as usual
+	if (options.simpointInterval > 0)
+	{
+		std::unique_ptr<MIPS_5Stage> functional(new MIPS_5Stage(program));
+		SimPoints points = selectSimPoints(*functional, program, options.simpointInterval, options.maxClusters);
+		functional.reset();
+		if (!points.points.empty())
+		{
+			printSimPoints(points, std::cout);
+			std::vector<double> cycles(selected.size());
+			std::vector<std::thread> threads;
+			for (size_t i = 0; i < selected.size(); ++i)
+				threads.emplace_back([&, i]()
+									 { cycles[i] = selected[i]->estimate(program, points); });
+			for (std::thread &thread : threads)
+				thread.join();
+			for (size_t i = 0; i < selected.size(); ++i)
+				std::cout << selected[i]->name << ": estimated " << std::llround(cycles[i]) << " cycles\n";
+			return 0;
+		}
+	}
+
+	if (options.smartsError > 0 && program->loadError == SUCCESS && program->commands.size() < MIPS_5Stage::MAX / 4)
+	{
+		std::vector<SmartsEstimate> estimates(selected.size());
+		std::vector<std::thread> threads;
+		for (size_t i = 0; i < selected.size(); ++i)
+			threads.emplace_back([&, i]()
+								 { estimates[i] = selected[i]->sample(program, options.smartsError, options.smartsUnit, options.smartsWarming); });
+		for (std::thread &thread : threads)
+			thread.join();
+		for (size_t i = 0; i < selected.size(); ++i)
+			printSmartsEstimate(selected[i]->name, estimates[i], options.smartsUnit, std::cout);
+		return 0;
+	}
+
+	if (options.memoize && program->loadError == SUCCESS && program->commands.size() < MIPS_5Stage::MAX / 4)
+	{
+		std::vector<MemoizedTiming> timings(selected.size());
+		std::vector<std::thread> threads;
+		for (size_t i = 0; i < selected.size(); ++i)
+			threads.emplace_back([&, i]()
+								 { timings[i] = selected[i]->memoize(program, options.validateMemo); });
+		for (std::thread &thread : threads)
+			thread.join();
+		for (size_t i = 0; i < selected.size(); ++i)
+			printMemoizedTiming(selected[i]->name, timings[i], std::cout);
+		return 0;
+	}
+
+	if (selected.size() == 1)
+	{
+		selected[0]->run(program, std::cout, std::cerr, options);
+		return 0;
+	}
+
+	std::vector<ModelOutput> outputs(selected.size());
+	const char *directory = getenv("TMPDIR");
+	for (ModelOutput &output : outputs)
+	{
+		std::string path = std::string(directory && *directory ? directory : "/tmp") + "/mips_XXXXXX";
+		int fd = mkstemp(&path[0]);
+		if (fd < 0)
+		{
+			std::cerr << "Temporary file could not be created. Terminating...\n";
+			return 0;
+		}
+		close(fd);
+		output.path = path;
+		output.out.open(path, std::ios::binary);
+	}
+
+	std::vector<std::thread> threads;
+	for (size_t i = 0; i < selected.size(); ++i)
+		threads.emplace_back(selected[i]->run, program, std::ref(outputs[i].out), std::ref(outputs[i].err), options);
+	for (std::thread &thread : threads)
+		thread.join();
+
+	for (size_t i = 0; i < selected.size(); ++i)
+	{
+		outputs[i].out.close();
+		std::cout << "== " << selected[i]->name << " ==\n";
+		std::ifstream in(outputs[i].path, std::ios::binary);
+		if (in.peek() != std::ifstream::traits_type::eof())
+			std::cout << in.rdbuf();
+		std::cout.flush();
+		std::cerr << outputs[i].err.str();
+		std::remove(outputs[i].path.c_str());
+	}
+	return 0;
+}
@@ -0,0 +1,4 @@
+addi $ra, $zero, 7
+addi $t0, $zero, -4
+lw $t1, 0($t0)
+addi $t2, $zero, 1
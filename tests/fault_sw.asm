@@ -0,0 +1,4 @@
+addi $ra, $zero, 7
+addi $t0, $zero, 4096
+sw $ra, 2($t0)
+addi $t2, $zero, 1
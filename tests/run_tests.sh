@@ -0,0 +1,18 @@
+#!/bin/bash
+# every model on an lw and an sw whose address is outside the data segment: the run must stop at that
+# line with the invalid address report, and $ra, set before it, must keep its value
+cd "$(dirname "$0")/.."
+fail=0
+for model in 5stage 5stage_bypass 79stage 79stage_bypass; do
+	for test in fault_lw fault_sw; do
+		output=$(./$model tests/$test.asm 2>&1)
+		ra=$(echo "$output" | awk 'NF == 32 { ra = $32 } END { print ra }')
+		if ! echo "$output" | grep -q "Error encountered at line 3:" || [ "$ra" != 7 ]; then
+			echo "FAIL $model $test"
+			fail=1
+		fi
+	done
+done
+rm -f tests/*.mipsbin
+[ $fail = 0 ] && echo "all tests passed"
+exit $fail